@@ -0,0 +1,93 @@
+#ifndef BETWEENMASKS_H
+#define BETWEENMASKS_H
+
+#include <vector>
+using std::vector;
+
+#include "boardlocation.h"
+#include "boardset.h"
+#include "lineid.h"
+#include "linedb.h"
+#include "linetable.h"
+
+// For every line in the LineTable, the interior points of the line (all
+// its pixels but src and dst) as a BoardSet. Two intersections can see
+// each other, past a set of stones, exactly when no stone lies between
+// them, so a visibility test is a single AND against the stones, with
+// no per-Board bookkeeping. Built once per board size, by instance(),
+// or mapped from the line database if mklinedb saved them (linedb.h).
+
+template<size_t NRows, size_t NCols> class BetweenMasks {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef LineTable<NRows, NCols> LineTableRC;
+  typedef typename LineTableRC::LineIndex LineIndex;
+  typedef BoardSet<NRows, NCols> BoardSetRC;
+
+  static BetweenMasks const &instance() {
+    static BetweenMasks const masks;
+    return masks;
+  }
+
+  BoardSetRC const &operator[](LineIndex index) const {
+    return masksAt[index];
+  }
+
+  bool canSee(LocationRC src, LocationRC dst, BoardSetRC const &stones) const {
+    if (src == dst) {
+      return true;
+    }
+    return (masksAt[LineTableRC::indexOf(LineIdRC(src, dst))] & stones).none();
+  }
+
+  // Every intersection, other than src itself, that src can see past
+  // stones, in one pass over the masks of the lines out of src.
+
+  BoardSetRC visibleFrom(LocationRC src, BoardSetRC const &stones) const {
+    BoardSetRC visible;
+
+    for (size_t dst = 0; dst < LineTableRC::nPoints; dst += 1) {
+      if (dst != size_t(src)) {
+	LineIndex id = LineTableRC::indexOf(LineIdRC(src, LocationRC(dst)));
+	visible[dst] = (masksAt[id] & stones).none();
+      }
+    }
+    return visible;
+  }
+
+private:
+  BetweenMasks() :
+    masks (),
+    masksAt (0)
+  {
+    LineDb const *db =
+      LineDb::find(NRows, NCols, Directed, sizeof(typename LineTableRC::Pixel), sizeof(BoardSetRC), LineTableRC::nLines);
+
+    if (db && db->sectionSize(LineDbBetweenMasks) == LineTableRC::nLines * sizeof(BoardSetRC)) {
+      masksAt = static_cast<BoardSetRC const *>(db->section(LineDbBetweenMasks));
+      return;
+    }
+
+    LineTableRC const &lines = LineTableRC::instance();
+
+    masks.resize(LineTableRC::nLines);
+
+    for (LineIndex id = 0; id < lines.size(); id += 1) {
+      LineIdRC lineId = LineTableRC::lineIdOf(id);
+
+      for (auto const &l : lines[id]) {
+	if (!(l == lineId.src || l == lineId.dst)) {
+	  masks[id][l] = 1;
+	}
+      }
+    }
+    masksAt = &masks[0];
+  }
+  BetweenMasks(BetweenMasks const &);
+
+  vector<BoardSetRC> masks;
+  BoardSetRC const *masksAt;
+};
+
+#endif // BETWEENMASKS_H
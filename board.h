@@ -0,0 +1,378 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include <bitset>
+using std::bitset;
+
+#include <type_traits>
+using std::conditional;
+
+#include <vector>
+using std::vector;
+
+#include "rarray.h"
+#include "boardlocation.h"
+#include "lineid.h"
+#include "line.h"
+#include "linetable.h"
+#include "lineset.h"
+#include "trace.h"
+#include "zobrist.h"
+
+enum State {
+  Empty,
+  Black,
+  White,
+
+  EoState
+};
+
+inline char const *nameOf(State s)
+{
+  return s == Black ? "Black" : (s == White) ? "White" : "Empty";
+}
+
+template<size_t NRows, size_t NCols, typename Table = LineTable<NRows, NCols>> class Intersection : public LineSet {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef Table LineTableRC;
+  typedef typename LineTableRC::LineIndex LineIndex;
+
+  Intersection() :
+    LineSet (LineTableRC::nLines),
+    state (Empty)
+  {
+  }
+
+  // The number of live lines through this intersection.
+
+  size_t size() const {
+    return count();
+  }
+
+  bool is(State s) const {
+    return state == s;
+  }
+
+  void put(State s) {
+    state = s;
+  }
+
+private:
+  State state;
+};
+
+// Table is where the Board gets its lines: LineTable (built at startup,
+// one line per ordered pair, or per unordered pair if Undirected),
+// StaticLineTable (built by the compiler), SymmetricLineTable (only
+// the canonical lines, built at startup) or ReflectedLineTable (the
+// straight lines plus those bouncing off the edges, built at startup).
+//
+// Trace is what put() reports as it goes (see trace.h): nothing, by
+// default, or the text it has always printed, or binary records.
+//
+// Key is the Zobrist hash of the stones (see zobrist.h), kept by put(),
+// putMany() and undo(): uint64_t, by default, or ZobristKey128.
+
+template<size_t NRows, size_t NCols, typename Table = LineTable<NRows, NCols>, typename Trace = NoTrace, typename Key = uint64_t>
+class Board : public rarray<Intersection<NRows, NCols, Table>, NRows, NCols> {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef Table LineTableRC;
+  typedef typename LineTableRC::LineIndex LineIndex;
+  typedef Intersection<NRows, NCols, Table> IntersectionRC;
+  typedef Zobrist<NRows, NCols, Key> ZobristRC;
+
+  // Each table knows the most lines through any one point: about N^3
+  // straight lines on an N x N board (7200 at the centre of 19x19), so
+  // the counts fit in 16 bits up to 40x40 or so. Bank shots can take
+  // 32 (over 86,000 lines cross the centre of 13x13 with three bounces).
+
+  static_assert(LineTableRC::maxLinesThrough <= 0xffffffff, "Board: too many lines for a 32-bit Count");
+
+  typedef typename conditional<(LineTableRC::maxLinesThrough <= 0xffff), uint16_t, uint32_t>::type Count;
+  typedef rarray<Count, NRows, NCols> CountsRC;
+
+  Board(Trace const &_trace = Trace()) :
+    trace (_trace),
+    allLines (LineTableRC::instance()),
+    blocked (LineTableRC::nLines),
+    positionHash ()
+  {
+    // Remember the lines through each touched intersection (copied
+    // whole, if the table came with them), and how many there are.
+
+    if (allLines.membership(0)) {
+      for (size_t l = 0; l < LineTableRC::nPoints; l += 1) {
+	(*this)[l].assign(allLines.membership(l));
+      }
+    } else {
+      for (LineIndex id = 0; id < allLines.size(); id += 1) {
+	for (auto const &l : allLines[id]) {
+	  (*this)[l].set(id);
+	}
+      }
+    }
+    for (size_t l = 0; l < LineTableRC::nPoints; l += 1) {
+      nLinesAt[l] = Count((*this)[l].size());
+    }
+
+    // A line is blocked at most once, and a point filled at most once,
+    // before being undone, so the journal never has to grow.
+
+    erased.reserve(LineTableRC::nLines);
+    filled.reserve(LineTableRC::nPoints);
+    moves.reserve(LineTableRC::nPoints);
+  }
+
+  // Put a stone of State s at l, if l is empty, blocking every line
+  // that passes through l, and journal the blocked lines so undo() can
+  // restore them. Returns true iff a stone was placed.
+
+  bool put(LocationRC l, State s) {
+    trace.put(l, s, nameOf(s));
+
+    bool placed = false;
+
+    if ((*this)[l].is(Empty)) {
+      IntersectionRC &p = (*this)[size_t(l)];
+
+      p.put(s);
+      toggle(l, s);
+      moves.push_back(Move(filled.size(), erased.size()));
+      filled.push_back(l);
+      placed = true;
+
+      // The stone blocks every live line through l that doesn't end
+      // at l. Gather those into one mask, and note every intersection
+      // they touch...
+
+      bitset<NRows * NCols> touched;
+
+      blocked = p;
+      p.forEach([&](size_t id) {
+	  LineIdRC lineId = LineTableRC::lineIdOf(LineIndex(id));
+
+	  trace.line(id, lineId);
+
+	  if (l == lineId.src || l == lineId.dst) {
+	    blocked.reset(id);
+	    return;
+	  }
+
+	  for (auto const &q : allLines[LineIndex(id)]) {
+	    trace.pixel(q);
+
+	    touched.set(q);
+	    nLinesAt[q] -= 1;
+	  }
+	  trace.blocked();
+
+	  erased.push_back(LineIndex(id));
+	});
+
+      // ... then clear the whole mask from each of them at once.
+
+      for (size_t q = 0; q < touched.size(); q += 1) {
+	if (touched[q]) {
+	  (*this)[q].andNot(blocked);
+	}
+      }
+    }
+    trace.done(placed);
+
+    return placed;
+  }
+
+  // Put stones[i], of State colors[i], for every i, as if by put() in
+  // turn, but blocking each line only once: gather the live lines
+  // through all the new stones, then block those with a new stone
+  // anywhere but at an end, for loading whole positions. Points already
+  // filled (or filled earlier in stones) are skipped. The batch is
+  // journalled as one move, and isn't traced. Returns the number of
+  // stones placed.
+
+  size_t putMany(vector<LocationRC> const &stones, vector<State> const &colors) {
+    assert(stones.size() == colors.size());
+
+    bitset<NRows * NCols> added;
+    size_t nPlaced = 0;
+
+    moves.push_back(Move(filled.size(), erased.size()));
+    blocked.clear();
+    for (size_t i = 0; i < stones.size(); i += 1) {
+      IntersectionRC &p = (*this)[size_t(stones[i])];
+
+      if (p.is(Empty)) {
+	p.put(colors[i]);
+	toggle(stones[i], colors[i]);
+	filled.push_back(stones[i]);
+	added.set(stones[i]);
+	blocked.orWith(p);
+	nPlaced += 1;
+      }
+    }
+    if (nPlaced == 0) {
+      moves.pop_back();
+      return 0;
+    }
+
+    blocked.forEach([&](size_t id) {
+	LineIdRC lineId = LineTableRC::lineIdOf(LineIndex(id));
+	auto const &line = allLines[LineIndex(id)];
+
+	bool isBlocked = false;
+	for (auto const &q : line) {
+	  if (added[q] && !(q == lineId.src || q == lineId.dst)) {
+	    isBlocked = true;
+	    break;
+	  }
+	}
+	if (!isBlocked) {
+	  return;
+	}
+
+	for (auto const &q : line) {
+	  (*this)[q].reset(id);
+	  nLinesAt[q] -= 1;
+	}
+	erased.push_back(LineIndex(id));
+      });
+
+    return nPlaced;
+  }
+
+  // Take back the most recent put() that placed a stone, or putMany()
+  // that placed any, restoring the lines blocked, in LIFO order.
+
+  void undo() {
+    assert(!moves.empty());
+
+    Move const &move = moves.back();
+
+    for (size_t e = move.firstErased; e < erased.size(); e += 1) {
+      LineIndex id = erased[e];
+
+      for (auto const &q : allLines[id]) {
+	(*this)[q].set(id);
+	nLinesAt[q] += 1;
+      }
+    }
+    erased.resize(move.firstErased);
+
+    for (size_t f = move.firstFilled; f < filled.size(); f += 1) {
+      IntersectionRC &p = (*this)[size_t(filled[f])];
+
+      toggle(filled[f], p.is(White) ? White : (p.is(Black) ? Black : Empty));
+      p.put(Empty);
+    }
+    filled.resize(move.firstFilled);
+    moves.pop_back();
+  }
+
+  // The number of live lines through every intersection, kept up to
+  // date by put() and undo(), for reading as a heatmap in place.
+
+  CountsRC const &counts() const {
+    return nLinesAt;
+  }
+
+  // The Zobrist hash of the stones on the board; and of the position
+  // with toMove to play, which differs by the side-to-move key when
+  // White is to play.
+
+  Key const &hash() const {
+    return positionHash;
+  }
+  Key hash(State toMove) const {
+    return toMove == White ? positionHash ^ ZobristRC::instance().whiteToMove() : positionHash;
+  }
+
+  Trace &tracer() {
+    return trace;
+  }
+  Trace const &tracer() const {
+    return trace;
+  }
+
+  void fprint(FILE *out) const {
+    fprintf(stdout, " ");
+    for (size_t j = 0; j < NCols; j += 1) {
+      fprintf(stdout, "       %c", char(j + 'a'));
+    }
+    fprintf(stdout, "\n");
+    for (size_t i = 0; i < NRows; i += 1) {
+      fprintf(stdout, "%c", char(i + 'a'));
+
+      for (size_t j = 0; j < NCols; j += 1) {
+	LocationRC l(i, j);
+	IntersectionRC const &p = (*this)[size_t(l)];
+
+	fprintf(stdout,
+		" %5lu %c",
+		size_t(nLinesAt[l]),
+		p.is(Black) ? '@' : (p.is(White) ? 'O' : '.')
+	       );
+      }
+      fprintf(stdout, "\n");
+    }
+    for (size_t i = 0; i < NRows; i += 1) {
+      for (size_t j = 0; j < NCols; j += 1) {
+	LocationRC l(i, j);
+	IntersectionRC const &p = (*this)[size_t(l)];
+
+	fprintf(stdout, "Board[");
+	l.fprint(stdout);
+	fprintf(stdout, "] = { state=%s, { ", p.is(Black) ? "Black" : (p.is(White) ? "White" : "Empty"));
+	char const *comma = "";
+	p.forEach([&](size_t id) {
+	    fprintf(stdout, "%s", comma);
+	    LineTableRC::lineIdOf(LineIndex(id)).fprint(stdout);
+	    comma = ", ";
+	  });
+	fprintf(stdout, " }\n");
+      }
+      fprintf(stdout, "\n");
+    }
+  }
+
+private:
+  void toggle(LocationRC l, State s) {
+    if (s != Empty) {
+      positionHash ^= ZobristRC::instance().stone(l, s == White);
+    }
+  }
+
+  struct Move {
+    Move(size_t _firstFilled, size_t _firstErased) :
+      firstFilled (_firstFilled),
+      firstErased (_firstErased)
+    {
+    }
+
+    size_t firstFilled;
+    size_t firstErased;
+  };
+
+  Trace trace;
+  LineTableRC const &allLines;
+  LineSet blocked;
+  CountsRC nLinesAt;
+  Key positionHash;
+
+  // The undo journal: the points filled and the lines blocked by every
+  // put() and putMany() still in effect, oldest first, and where each
+  // one's points and lines begin.
+
+  vector<LocationRC> filled;
+  vector<LineIndex> erased;
+  vector<Move> moves;
+};
+
+#endif // BOARD_H
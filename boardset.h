@@ -0,0 +1,27 @@
+#ifndef BOARDSET_H
+#define BOARDSET_H
+
+#include <bitset>
+using std::bitset;
+
+template<size_t NRows, size_t NCols> struct BoardSet: public bitset<NRows * NCols> {
+  typedef bitset<NRows * NCols> BitSet;
+
+  BoardSet() {
+    BitSet::reset();
+  }
+
+  bool operator()(size_t row, size_t col) const {
+    return (*this)[toIndex(row, col)];
+  }
+  typename BitSet::reference operator()(size_t row, size_t col) {
+    return (*this)[toIndex(row, col)];
+  }
+
+private:
+  static size_t toIndex(size_t row, size_t col) {
+    return (row * NCols) + col;
+  }
+};
+
+#endif // BOARDSET_H
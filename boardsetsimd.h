@@ -0,0 +1,204 @@
+#ifndef BOARDSETSIMD_H
+#define BOARDSETSIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The word-array kernels under PaddedBoardSet: and, or, xor, and-not,
+// popcount, any, and shifts by less than a word, over a board's NW
+// words, NW a multiple of four. Each comes in three versions: portable
+// scalar, AVX2 (four words to a register) and AVX-512 (eight, with a
+// masked tail).
+//
+// The version is fixed when the program is compiled, so every kernel
+// inlines into its caller: AVX2 if the compiler was told the CPU has it
+// (-mavx2, -march=native), else scalar. -DBOARDSET_SIMD=0, 1 or 2 picks
+// scalar, AVX2 or AVX-512 regardless. AVX-512 is never the default, as
+// on 8 words it measures no faster than scalar, and choosing at run
+// time, per call, cost more than the operations themselves. Build with
+// -mpopcnt, at least: without it, count() calls libgcc a word at a
+// time. Only the vector versions need immintrin.h, so the scalar one
+// builds anywhere.
+//
+// A 19x19 board is 8 words: two AVX2 registers or one AVX-512 register.
+
+enum SimdOp {
+  SimdAnd,
+  SimdOr,
+  SimdXor,
+  SimdAndNot,			// a & ~b
+
+  EoSimdOp
+};
+
+#ifndef BOARDSET_SIMD
+#if defined(__AVX2__)
+#define BOARDSET_SIMD 1
+#else
+#define BOARDSET_SIMD 0
+#endif
+#endif
+
+#if BOARDSET_SIMD == 2 && !defined(__AVX512F__)
+#error "BOARDSET_SIMD=2 needs -mavx512f"
+#endif
+#if BOARDSET_SIMD == 1 && !defined(__AVX2__)
+#error "BOARDSET_SIMD=1 needs -mavx2"
+#endif
+
+#if BOARDSET_SIMD != 0
+#include <immintrin.h>
+#endif
+
+struct BoardSetSimd {
+  typedef uint64_t Word;
+
+  // a = a Op b.
+
+  template<size_t NW, SimdOp Op> static void apply(Word *a, Word const *b) {
+#if BOARDSET_SIMD == 2
+    for (size_t w = 0; w < NW; w += 8) {
+      __mmask8 m = tail(w, NW);
+      __m512i x = _mm512_maskz_loadu_epi64(m, a + w);
+      __m512i y = _mm512_maskz_loadu_epi64(m, b + w);
+      _mm512_mask_storeu_epi64(a + w, m, op512<Op>(x, y));
+    }
+#elif BOARDSET_SIMD == 1
+    static_assert(NW % 4 == 0, "BoardSetSimd: NW must be a multiple of 4");
+    for (size_t w = 0; w < NW; w += 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + w));
+      __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + w));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + w), op256<Op>(x, y));
+    }
+#else
+    for (size_t w = 0; w < NW; w += 1) {
+      a[w] = op<Op>(a[w], b[w]);
+    }
+#endif
+  }
+
+  template<size_t NW> static size_t count(Word const *a) {
+    size_t n = 0;
+    for (size_t w = 0; w < NW; w += 1) {
+      n += size_t(__builtin_popcountll(a[w]));
+    }
+    return n;
+  }
+
+  template<size_t NW> static bool any(Word const *a) {
+#if BOARDSET_SIMD == 2
+    __m512i bits = _mm512_setzero_si512();
+    for (size_t w = 0; w < NW; w += 8) {
+      bits = _mm512_or_si512(bits, _mm512_maskz_loadu_epi64(tail(w, NW), a + w));
+    }
+    return _mm512_test_epi64_mask(bits, bits) != 0;
+#elif BOARDSET_SIMD == 1
+    __m256i bits = _mm256_setzero_si256();
+    for (size_t w = 0; w < NW; w += 4) {
+      bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + w)));
+    }
+    return !_mm256_testz_si256(bits, bits);
+#else
+    Word bits = 0;
+    for (size_t w = 0; w < NW; w += 1) {
+      bits |= a[w];
+    }
+    return bits != 0;
+#endif
+  }
+
+  // out = in shifted up (towards higher bits) or down by 0 < bits < 64.
+  // Each word takes the bits shifted out of its neighbour: in the
+  // vector versions, the words of a register rotated by one, with the
+  // end word from the next register along (or zero) put in place.
+
+  template<size_t NW> static void shiftUp(Word *out, Word const *in, unsigned bits) {
+#if BOARDSET_SIMD == 2
+    __m128i up = _mm_cvtsi32_si128(int(bits));
+    __m128i down = _mm_cvtsi32_si128(int(64 - bits));
+    __m512i below = _mm512_setzero_si512();
+    for (size_t w = 0; w < NW; w += 8) {
+      __mmask8 m = tail(w, NW);
+      __m512i x = _mm512_maskz_loadu_epi64(m, in + w);
+      __m512i prev = _mm512_maskz_alignr_epi64(0xff, x, below, 7);
+      _mm512_mask_storeu_epi64(out + w, m, _mm512_or_si512(_mm512_maskz_sll_epi64(0xff, x, up), _mm512_maskz_srl_epi64(0xff, prev, down)));
+      below = x;
+    }
+#elif BOARDSET_SIMD == 1
+    __m128i up = _mm_cvtsi32_si128(int(bits));
+    __m128i down = _mm_cvtsi32_si128(int(64 - bits));
+    for (size_t w = NW; 0 < w; w -= 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + w - 4));
+      __m256i prev = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 3));
+      prev = _mm256_insert_epi64(prev, static_cast<long long>(4 < w ? in[w - 5] : 0), 0);
+      __m256i y = _mm256_or_si256(_mm256_sll_epi64(x, up), _mm256_srl_epi64(prev, down));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w - 4), y);
+    }
+#else
+    for (size_t w = NW; 0 < w; w -= 1) {
+      out[w - 1] = (in[w - 1] << bits) | (1 < w ? in[w - 2] >> (64 - bits) : 0);
+    }
+#endif
+  }
+  template<size_t NW> static void shiftDown(Word *out, Word const *in, unsigned bits) {
+#if BOARDSET_SIMD == 2
+    __m128i down = _mm_cvtsi32_si128(int(bits));
+    __m128i up = _mm_cvtsi32_si128(int(64 - bits));
+    __m512i x = _mm512_maskz_loadu_epi64(tail(0, NW), in);
+    for (size_t w = 0; w < NW; w += 8) {
+      __m512i above = w + 8 < NW ? _mm512_maskz_loadu_epi64(tail(w + 8, NW), in + w + 8) : _mm512_setzero_si512();
+      __m512i next = _mm512_maskz_alignr_epi64(0xff, above, x, 1);
+      _mm512_mask_storeu_epi64(out + w, tail(w, NW), _mm512_or_si512(_mm512_maskz_srl_epi64(0xff, x, down), _mm512_maskz_sll_epi64(0xff, next, up)));
+      x = above;
+    }
+#elif BOARDSET_SIMD == 1
+    __m128i down = _mm_cvtsi32_si128(int(bits));
+    __m128i up = _mm_cvtsi32_si128(int(64 - bits));
+    for (size_t w = 0; w < NW; w += 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in + w));
+      __m256i next = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(0, 3, 2, 1));
+      next = _mm256_insert_epi64(next, static_cast<long long>(w + 4 < NW ? in[w + 4] : 0), 3);
+      __m256i y = _mm256_or_si256(_mm256_srl_epi64(x, down), _mm256_sll_epi64(next, up));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w), y);
+    }
+#else
+    for (size_t w = 0; w < NW; w += 1) {
+      out[w] = (in[w] >> bits) | (w + 1 < NW ? in[w + 1] << (64 - bits) : 0);
+    }
+#endif
+  }
+
+private:
+  template<SimdOp Op> static Word op(Word a, Word b) {
+    return Op == SimdAnd ? a & b : Op == SimdOr ? a | b : Op == SimdXor ? a ^ b : a & ~b;
+  }
+
+#if BOARDSET_SIMD == 1
+  template<SimdOp Op> static __m256i op256(__m256i a, __m256i b) {
+    return Op == SimdAnd ? _mm256_and_si256(a, b) :
+	   Op == SimdOr ? _mm256_or_si256(a, b) :
+	   Op == SimdXor ? _mm256_xor_si256(a, b) :
+	   _mm256_andnot_si256(b, a);
+  }
+#endif
+
+  // AVX-512 works eight words at a time, the last register masked to
+  // the words that are there. The maskz forms are used throughout, as
+  // the plain ones start from an undefined register, which GCC warns
+  // about.
+
+#if BOARDSET_SIMD == 2
+  static __mmask8 tail(size_t w, size_t nw) {
+    return nw - w < 8 ? __mmask8((1u << (nw - w)) - 1) : __mmask8(0xff);
+  }
+
+  template<SimdOp Op> static __m512i op512(__m512i a, __m512i b) {
+    return Op == SimdAnd ? _mm512_and_si512(a, b) :
+	   Op == SimdOr ? _mm512_or_si512(a, b) :
+	   Op == SimdXor ? _mm512_xor_si512(a, b) :
+	   _mm512_maskz_andnot_epi64(0xff, b, a);
+  }
+#endif
+};
+
+#endif // BOARDSETSIMD_H
@@ -1,25 +1,29 @@
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #include <algorithm>
 
 #include <array>
 using std::array;
 
-#include <bitset>
-using std::bitset;
-
 #include <map>
 using std::map;
 
 #include <set>
 using std::set;
 
+#include <vector>
+using std::vector;
+
 #include <utility>
 using std::pair;
 
+#include "paddedboardset.h"
 #include "sarray.h"
+#include "zobrist.h"
 
 size_t const bSize = 19;
 
@@ -123,56 +127,217 @@ char const toChar(Point const &i) {
 template<typename T> struct PArray: public array<T, size_t(EoPoint)> {
 };
 
-template<size_t NRows, size_t NCols> struct BoardSet: public bitset<NRows * NCols> {
-  typedef bitset<NRows * NCols> BitSet;
+template<size_t NRows, size_t NCols> class BoardModel;
 
-  BoardSet() {
-    BitSet::reset();
+struct NeighborhoodCounts: PArray<size_t> {
+  NeighborhoodCounts() {
+    std::fill(begin(), end(), 0);
   }
+  void fprint(FILE *out) const {
+    fprintf(out, "%lu%lu%lu%lu", (*this)[Illegal], (*this)[Empty], (*this)[Black], (*this)[White]);
+  }
+};
 
-  bool operator()(size_t row, size_t col) const {
-    return (*this)[toIndex(row, col)];
+// For every point, how many of its four neighbours are each Point, in
+// bit planes: count(p)[k] holds bit k of every point's count of p. Each
+// count is the sum of four shifted copies of p's plane, added a bit at
+// a time for the whole board at once: two half adders, then the carries
+// combined. The padding is the Illegal plane, so points on the edges
+// need nothing extra.
+
+template<size_t NRows, size_t NCols> struct NeighborhoodPlanes {
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+
+  static size_t const nBits = 3;	// counts are 0..4
+
+  void Fill(BoardModel<NRows, NCols> const &board) {
+    for (Point p = Illegal; p < EoPoint; p = Point(size_t(p) + 1)) {
+      BoardSetRC const a = board[p].shifted(N);
+      BoardSetRC const b = board[p].shifted(S);
+      BoardSetRC const c = board[p].shifted(E);
+      BoardSetRC const d = board[p].shifted(W);
+
+      BoardSetRC const ab = a ^ b;
+      BoardSetRC const cd = c ^ d;
+      BoardSetRC const abCarry = a & b;
+      BoardSetRC const cdCarry = c & d;
+
+      counts[p][0] = ab ^ cd;
+      counts[p][1] = abCarry ^ cdCarry ^ (ab & cd);
+      counts[p][2] = abCarry & cdCarry;
+    }
   }
-  typename BitSet::reference operator()(size_t row, size_t col) {
-    return (*this)[toIndex(row, col)];
+
+  array<BoardSetRC, nBits> const &count(Point p) const {
+    return counts[p];
   }
 
-private:
-  static size_t toIndex(size_t row, size_t col) {
-    return (row * NCols) + col;
+  PArray<array<BoardSetRC, nBits>> counts;
+};
+
+template<size_t NRows, size_t NCols> struct BoardNeighborhoodCounts: public rarray<NeighborhoodCounts, NRows, NCols> {
+  BoardNeighborhoodCounts() {
+    NeighborhoodCounts empty;
+
+    std::fill(this->begin(), this->end(), empty);
+  }
+
+  // The counts of NeighborhoodPlanes, a point at a time.
+
+  void Fill(BoardModel<NRows, NCols> const &board) {
+    NeighborhoodPlanes<NRows, NCols> planes;
+    planes.Fill(board);
+
+    std::fill(this->begin(), this->end(), NeighborhoodCounts());
+
+    for (Point p = Illegal; p < EoPoint; p = Point(size_t(p) + 1)) {
+      for (size_t k = 0; k < planes.nBits; k += 1) {
+	planes.count(p)[k].forEach([&](size_t i, size_t j) { (*this)(i, j)[p] += size_t(1) << k; });
+      }
+    }
+  }
+
+  void fprint(FILE *out) const {
+    fprintf(out, " ");
+    for (size_t j = 0; j < NCols; j += 1) {
+      fprintf(out, "    %c", char('a' + j));
+    }
+    fprintf(out, "\n");
+
+    for (size_t i = 0; i < NRows; i += 1) {
+      fprintf(out, "%c", char('a' + i));
+
+      for (size_t j = 0; j < NCols; j += 1) {
+	fprintf(out, " ");
+	(*this)(i, j).fprint(out);
+      }
+
+      fprintf(out, "\n");
+    }
+
+    fprintf(out, "\n");
   }
 };
 
-template<size_t NRows, size_t NCols> class BoardModel: public array<BoardSet<NRows, NCols>, size_t(EoPoint)> {
+// Every point's Point, two bits each, at the point's PaddedBoardSet
+// index, so the padding reads as Illegal (0). pointAt() is a shift and
+// a mask; rowAt() is the three points (r, c - 1..c + 1), the first in
+// the low bits, from one unaligned load: the six bits are at most eight
+// bytes in, and there are eight bytes of slack past the end.
+
+template<size_t NRows, size_t NCols> class PointMailbox {
 public:
-  BoardModel() {
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+
+  static size_t const nBytes = ((2 * BoardSetRC::nBits) + 7) / 8;
+
+  PointMailbox() {
     reset();
   }
 
+  void reset() {
+    bytes.fill(0);
+  }
+
   Point pointAt(int i, int j) const {
-    if (i < 0 || NRows <= i || j < 0 || NCols <= j) {
-      return Illegal;
-    }
+    size_t k = BoardSetRC::toIndex(i, j);
+    return Point((bytes[k / 4] >> (2 * (k % 4))) & 0x3);
+  }
+  unsigned rowAt(int i, int j) const {
+    size_t k = BoardSetRC::toIndex(i, j - 1);
+    uint64_t bits;
+    memcpy(&bits, &bytes[k / 4], sizeof(bits));
+    return unsigned(bits >> (2 * (k % 4))) & 0x3f;
+  }
 
-    if ((*this)[Black](i, j)) {
-      return Black;
-    }
-    if ((*this)[White](i, j)) {
-      return White;
+  void put(int i, int j, Point who) {
+    size_t k = BoardSetRC::toIndex(i, j);
+    unsigned shift = 2 * (k % 4);
+    bytes[k / 4] = uint8_t((bytes[k / 4] & ~(0x3 << shift)) | (unsigned(who) << shift));
+  }
+
+private:
+  array<uint8_t, nBytes + sizeof(uint64_t)> bytes;
+};
+
+// One PaddedBoardSet per Point. The padding around the board is the
+// Illegal plane, so pointAt() needs no bounds checks one step off the
+// board, and neighbours and liberties of whole groups are shifts.
+//
+// The same position is kept again in a PointMailbox, for reading single
+// points. Both are written only by put() and reset(), so they agree;
+// the planes are read-only from outside.
+//
+// A BoardModel made with keepCounts also keeps its neighbourhood counts,
+// built once by reset() and then patched by put(): a point changing from
+// one Point to another moves one count, in each of its four neighbours,
+// from the old Point to the new.
+//
+// put() and reset() also keep the position's 64-bit Zobrist hash (see
+// zobrist.h).
+
+template<size_t NRows, size_t NCols> class BoardModel {
+public:
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+  typedef PointMailbox<NRows, NCols> MailboxRC;
+  typedef Zobrist<NRows, NCols> ZobristRC;
+
+  explicit BoardModel(bool _keepCounts = false) : keepCounts (_keepCounts), positionHash (0) {
+    reset();
+  }
+
+  BoardSetRC const &operator[](Point p) const {
+    return planes[p];
+  }
+
+  Point pointAt(int i, int j) const {
+    return mailbox.pointAt(i, j);
+  }
+  unsigned rowAt(int i, int j) const {
+    return mailbox.rowAt(i, j);
+  }
+
+  void reset() {
+    positionHash = 0;
+    planes[Illegal] = BoardSetRC::padding();
+    planes[Black].reset();
+    planes[White].reset();
+    planes[Empty].set();
+
+    mailbox.reset();
+    for (size_t i = 0; i < NRows; i += 1) {
+      for (size_t j = 0; j < NCols; j += 1) {
+	mailbox.put(i, j, Empty);
+      }
     }
-    if ((*this)[Empty](i, j)) {
-      return Empty;
+
+    if (keepCounts) {
+      neighborhoodCounts.Fill(*this);
     }
+  }
 
-    assert((*this)[Black](i, j) || (*this)[White](i, j) || (*this)[Empty](i, j));
-    return Empty;
+  BoardNeighborhoodCounts<NRows, NCols> const &counts() const {
+    assert(keepCounts);
+    return neighborhoodCounts;
   }
 
-  void reset() {
-    (*this)[Illegal].reset();
-    (*this)[Black].reset();
-    (*this)[White].reset();
-    (*this)[Empty].set();
+  // The Zobrist hash of the stones; and of the position with toMove to
+  // play.
+
+  uint64_t hash() const {
+    return positionHash;
+  }
+  uint64_t hash(Point toMove) const {
+    return toMove == White ? positionHash ^ ZobristRC::instance().whiteToMove() : positionHash;
+  }
+
+  // The points next to mask, and those of them that are empty.
+
+  BoardSetRC neighbours(BoardSetRC const &mask) const {
+    return mask.neighbours();
+  }
+  BoardSetRC liberties(BoardSetRC const &mask) const {
+    return mask.neighbours() & (*this)[Empty];
   }
 
   bool isEmpty(size_t i, size_t j) const {
@@ -204,24 +369,33 @@ public:
   }
 
   void put(size_t i, size_t j, Point who) {
-    switch (who) {
-    case Black:
-      (*this)[Black](i, j) = 1;
-      (*this)[White](i, j) = 0;
-      (*this)[Empty](i, j) = 0;
-      break;
-    case White:
-      (*this)[Black](i, j) = 0;
-      (*this)[White](i, j) = 1;
-      (*this)[Empty](i, j) = 0;
-      break;
-    case Empty:
-      (*this)[Black](i, j) = 0;
-      (*this)[White](i, j) = 0;
-      (*this)[Empty](i, j) = 1;
-      break;
-    default:
-      assert(who == Black || who == White || who == Empty);
+    assert(who == Black || who == White || who == Empty);
+
+    planes[Black](i, j) = who == Black;
+    planes[White](i, j) = who == White;
+    planes[Empty](i, j) = who == Empty;
+
+    Point was = mailbox.pointAt(i, j);
+    mailbox.put(i, j, who);
+
+    if (was != who) {
+      toggle(i, j, was);
+      toggle(i, j, who);
+    }
+
+    if (keepCounts && was != who) {
+      if (0 < i) {
+	moveCount(i - 1, j, was, who);
+      }
+      if (i < NRows - 1) {
+	moveCount(i + 1, j, was, who);
+      }
+      if (0 < j) {
+	moveCount(i, j - 1, was, who);
+      }
+      if (j < NCols - 1) {
+	moveCount(i, j + 1, was, who);
+      }
     }
   }
 
@@ -244,83 +418,24 @@ public:
 
     fprintf(out, "\n");
   }
-};
 
-struct NeighborhoodCounts: PArray<size_t> {
-  NeighborhoodCounts() {
-    std::fill(begin(), end(), 0);
-  }
-  void fprint(FILE *out) const {
-    fprintf(out, "%lu%lu%lu%lu", (*this)[Illegal], (*this)[Empty], (*this)[Black], (*this)[White]);
-  }
-};
-
-template<size_t NRows, size_t NCols> struct BoardNeighborhoodCounts: public rarray<NeighborhoodCounts, NRows, NCols> {
-  BoardNeighborhoodCounts() {
-    NeighborhoodCounts empty;
-
-    std::fill(this->begin(), this->end(), empty);
+private:
+  void moveCount(size_t i, size_t j, Point from, Point to) {
+    neighborhoodCounts(i, j)[from] -= 1;
+    neighborhoodCounts(i, j)[to] += 1;
   }
 
-  void Fill(BoardModel<NRows, NCols> const &board) {
-    for (int i = 0; i < NRows; i += 1) {
-      for (int j = 0; j < NCols; j += 1) {
-	Point point = board.pointAt(i, j);
-
-	if (0 < i) {
-	  (*this)(i - 1, j)[point] += 1;
-	}
-	if (i < (NRows - 1)) {
-	  (*this)(i + 1, j)[point] += 1;
-	}
-	if (0 < j) {
-	  (*this)(i, j - 1)[point] += 1;
-	}
-	if (j < (NCols - 1)) {
-	  (*this)(i, j + 1)[point] += 1;
-	}
-
-	// (*this)[i - 1][j][point] += 1;
-	// (*this)[i + 1][j][point] += 1;
-	// (*this)[i][j - 1][point] += 1;
-	// (*this)[i][j + 1][point] += 1;
-      }
-    }
-
-    for (size_t c = 0; c < NCols; c += 1) {
-      (*this)(        0, c)[Illegal] += 1;
-      (*this)(        1, c)[board.pointAt(        0, c)] += 1;      
-      (*this)(NCols - 2, c)[board.pointAt(NCols - 1, c)] += 1;      
-      (*this)(NCols - 1, c)[Illegal] += 1;
-    }
-    for (size_t r = 0; r < NRows; r += 1) {
-      (*this)(r,         0)[Illegal] += 1;
-      (*this)(r,         1)[board.pointAt(r,         0)] += 1;      
-      (*this)(r, NRows - 2)[board.pointAt(r, NRows - 1)] += 1;      
-      (*this)(r, NRows - 1)[Illegal] += 1;
+  void toggle(size_t i, size_t j, Point p) {
+    if (p == Black || p == White) {
+      positionHash ^= ZobristRC::instance().stone((i * NCols) + j, p == White);
     }
   }
 
-  void fprint(FILE *out) const {
-    fprintf(out, " ");
-    for (size_t j = 0; j < NCols; j += 1) {
-      fprintf(out, "    %c", char('a' + j));
-    }
-    fprintf(out, "\n");
-
-    for (size_t i = 0; i < NRows; i += 1) {
-      fprintf(out, "%c", char('a' + i));
-
-      for (size_t j = 0; j < NCols; j += 1) {
-	fprintf(out, " ");
-	(*this)(i, j).fprint(out);
-      }
-
-      fprintf(out, "\n");
-    }
-
-    fprintf(out, "\n");
-  }
+  array<BoardSetRC, size_t(EoPoint)> planes;
+  MailboxRC mailbox;
+  bool keepCounts;
+  uint64_t positionHash;
+  BoardNeighborhoodCounts<NRows, NCols> neighborhoodCounts;
 };
 
 pair<size_t, size_t> rcMap19x19[19][19] = {
@@ -386,8 +501,9 @@ template<size_t NRows, size_t NCols> struct Pattern {
     array<int, 9> points;
     size_t k = 0;
     for (int i = 0; i < 3; i += 1) {
+      unsigned bits = board.rowAt(r + i - 1, c);
       for (int j = 0; j < 3; j += 1) {
-	points[k] = unsigned(board.pointAt(r + i - 1, c + j - 1)) & 0x3;
+	points[k] = (bits >> (2 * j)) & 0x3;
 	// fprintf(stdout, "%c", toChar(Point(points[k])));
 	k += 1;
       }
@@ -484,105 +600,418 @@ template<size_t NRows, size_t NCols> struct BoardPatterns: public map<Pattern<NR
   }
 };
 
-template<size_t NRows, size_t NCols> class Group: set<pair<size_t, size_t>> {
-public:
-  Group(Point const &point):
-    groupOf (point)
-  {
-  }
+// A group of a position: a connected set of points of the same Point,
+// and its liberties, the empty points next to it (none, for a group of
+// empty points).
 
-  void Fill(BoardModel<NRows, NCols> const &board, size_t i, size_t j) {
-    assert(groupOf == board.pointAt(i, j));
+template<size_t NRows, size_t NCols> struct Group {
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
 
-    insert({ i, j });
+  Group(Point _point, BoardSetRC const &_points, BoardSetRC const &_liberties) :
+    point (_point),
+    points (_points),
+    liberties (_liberties)
+  {
   }
 
   void fprint(FILE *out) const {
+    char const *comma = "";
     fprintf(out, "{");
-    auto p = cbegin();
-    if (p != cend()) {
-      fprintf(out, " %c%c", char('a' + p->first), char('a' + p->second));
-      while (++p != cend()) {
-	fprintf(out, ", %c%c", char('a' + p->first), char('a' + p->second));
-      }
-    }
+    points.forEach([&](size_t i, size_t j) {
+      fprintf(out, "%s %c%c", comma, char('a' + i), char('a' + j));
+      comma = ",";
+    });
     fprintf(out, " }");
   }
 
-  Point point() const { return groupOf; }
+  Point point;
+  BoardSetRC points;
+  BoardSetRC liberties;
+};
+
+// Every group of a position, of every Point, found a Point at a time
+// as the connected parts of its plane (see PaddedBoardSet::forEachPart),
+// with no recursion however big a group is, and given its liberties as
+// it is found. Each group comes out in the order of its first point.
+// (An empty group has no liberties: every empty point beside it is in
+// it.)
 
-private:
-  Point groupOf;
+template<size_t NRows, size_t NCols> class Groups: public PArray<vector<Group<NRows, NCols>>> {
+public:
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+
+  void Fill(BoardModel<NRows, NCols> const &board) {
+    for (Point p = Illegal; p < EoPoint; p = Point(size_t(p) + 1)) {
+      (*this)[p].clear();
+      board[p].forEachPart(board[Empty], [&](BoardSetRC const &points, BoardSetRC const &liberties) {
+	(*this)[p].push_back(Group<NRows, NCols>(p, points, liberties));
+      });
+    }
+  }
+
+  void fprint(FILE *out) const {
+    fprintf(out, "Groups = {\n");
+    for (Point p = Illegal; p < EoPoint; p = Point(size_t(p) + 1)) {
+      fprintf(out, "  [%u] {\n", unsigned(p));
+      for (auto g = (*this)[p].begin(); g != (*this)[p].end(); g++) {
+	fprintf(out, "    ");
+	g->fprint(out);
+	fprintf(out, "\n");
+      }
+      fprintf(out, "  }\n");
+    }
+    fprintf(out, "}\n");
+  }
 };
 
-template<size_t NRows, size_t NCols> class Groups: public PArray<set<Group<NRows, NCols> *>> {
+// The stone groups of a game in play, kept up to date a stone at a time
+// rather than flood filled afresh: union-find over the points, by size
+// and with path halving, so finding a point's group is O(a(n)). Each
+// group's stones are also a circular list through next, for walking and
+// removing them, and each group's root keeps its number of stones and
+// its liberties. Every array is flat, one entry per point, so nothing
+// is allocated per move.
+
+template<size_t NRows, size_t NCols> class GroupTracker {
 public:
-  Groups() {
-    std::fill(pointGroups.begin(), pointGroups.end(), (Group<NRows, NCols> *) 0);
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+  typedef BoardModel<NRows, NCols> BoardModelRC;
+  typedef uint16_t Index;
+
+  static size_t const nPoints = NRows * NCols;
+  static constexpr Index none = Index(-1);
+
+  static_assert(nPoints < none, "GroupTracker: too many points for an Index");
+
+  GroupTracker() {
+    reset();
+  }
+
+  void reset() {
+    parent.fill(none);
   }
 
-  void Fill(BoardModel<NRows, NCols> const &board, Group<NRows, NCols> *group, size_t i, size_t j) {
-    assert(group);
+  // Add the stone just put at (i, j) on board: a group of its own,
+  // merged with any friendly group next to it. It takes a liberty from
+  // every group next to it, of either colour.
 
-    Point point = group->point();
+  void place(BoardModelRC const &board, size_t i, size_t j) {
+    Point who = board.pointAt(i, j);
+    Index p = indexOf(i, j);
 
-    assert(point == board.pointAt(i, j));
-    assert(!pointGroups(i, j));
+    assert(who == Black || who == White);
+    assert(parent[p] == none);
 
-    group->Fill(board, i, j);
-    pointGroups(i, j) = group;
+    BoardSetRC stone;
+    stone(i, j) = true;
 
-    if (0 < i) {
-      if (!pointGroups(i - 1, j) && point == board.pointAt(i - 1, j)) {
-	Fill(board, group, i - 1, j);
+    parent[p] = p;
+    next[p] = p;
+    nStones[p] = 1;
+    libs[p] = board.liberties(stone);
+
+    forEachNeighbour(i, j, [&](size_t ni, size_t nj) {
+      Index q = indexOf(ni, nj);
+      if (parent[q] != none) {
+	Index r = find(q);
+	libs[r](i, j) = false;
+	if (board.pointAt(ni, nj) == who) {
+	  unite(find(p), r);
+	}
       }
+    });
+  }
+
+  // Take the group at (i, j) off board, as captured: its points become
+  // empty, and liberties of the groups next to them.
+
+  void remove(BoardModelRC &board, size_t i, size_t j) {
+    Index r = find(indexOf(i, j));
+
+    Index p = r;
+    do {
+      board.put(p / NCols, p % NCols, Empty);
+      parent[p] = none;
+      p = next[p];
+    } while (p != r);
+
+    do {
+      forEachNeighbour(p / NCols, p % NCols, [&](size_t ni, size_t nj) {
+	Index q = indexOf(ni, nj);
+	if (parent[q] != none) {
+	  libs[find(q)](p / NCols, p % NCols) = true;
+	}
+      });
+      p = next[p];
+    } while (p != r);
+  }
+
+  bool isStone(size_t i, size_t j) const {
+    return parent[indexOf(i, j)] != none;
+  }
+
+  // The group at (i, j), which must be a stone, as its root's index.
+
+  Index group(size_t i, size_t j) const {
+    assert(isStone(i, j));
+    return find(indexOf(i, j));
+  }
+
+  size_t stones(size_t i, size_t j) const {
+    return nStones[group(i, j)];
+  }
+  size_t liberties(size_t i, size_t j) const {
+    return libs[group(i, j)].count();
+  }
+  BoardSetRC const &libertiesOf(size_t i, size_t j) const {
+    return libs[group(i, j)];
+  }
+
+  // Call f(row, col) for every stone of the group at (i, j).
+
+  template<typename F> void forEachStone(size_t i, size_t j, F f) const {
+    Index r = group(i, j);
+    Index p = r;
+    do {
+      f(p / NCols, p % NCols);
+      p = next[p];
+    } while (p != r);
+  }
+
+  BoardSetRC stonesOf(size_t i, size_t j) const {
+    BoardSetRC result;
+    forEachStone(i, j, [&](size_t si, size_t sj) { result(si, sj) = true; });
+    return result;
+  }
+
+private:
+  static Index indexOf(size_t i, size_t j) {
+    return Index((i * NCols) + j);
+  }
+
+  template<typename F> static void forEachNeighbour(size_t i, size_t j, F f) {
+    if (0 < i) {
+      f(i - 1, j);
     }
-    if (i < (bSize - 1)) {
-      if (!pointGroups(i + 1, j) && point == board.pointAt(i + 1, j)) {
-	Fill(board, group, i + 1, j);
-      }
+    if (i < NRows - 1) {
+      f(i + 1, j);
     }
     if (0 < j) {
-      if (!pointGroups(i, j - 1) && point == board.pointAt(i, j - 1)) {
-	Fill(board, group, i, j - 1);
-      }
+      f(i, j - 1);
     }
-    if (j < (bSize - 1)) {
-      if (!pointGroups(i, j + 1) && point == board.pointAt(i, j + 1)) {
-	Fill(board, group, i, j + 1);
-      }
+    if (j < NCols - 1) {
+      f(i, j + 1);
     }
   }
 
-  void Fill(BoardModel<NRows, NCols> const &board) {
-    for (size_t i = 0; i < bSize; i += 1) {
-      for (size_t j = 0; j < bSize; j += 1) {
-	if (!pointGroups(i, j)) {
-	  Point point = board.pointAt(i, j);
-	  Group<NRows, NCols> *group = new Group<NRows, NCols>(point);
-
-	  (*this)[point].insert(group);
-	  Fill(board, group, i, j);
-	}
+  // Path halving only shortens paths, so it's done even from const
+  // queries; parent is mutable for that.
+
+  Index find(Index p) const {
+    while (parent[p] != p) {
+      parent[p] = parent[parent[p]];
+      p = parent[p];
+    }
+    return p;
+  }
+
+  void unite(Index a, Index b) {
+    if (a == b) {
+      return;
+    }
+    if (nStones[a] < nStones[b]) {
+      std::swap(a, b);
+    }
+    parent[b] = a;
+    nStones[a] += nStones[b];
+    libs[a] |= libs[b];
+    std::swap(next[a], next[b]);
+  }
+
+  mutable array<Index, nPoints> parent;
+  array<Index, nPoints> next;
+  array<Index, nPoints> nStones;
+  array<BoardSetRC, nPoints> libs;
+};
+
+// The rules of Go, on a BoardModel and a GroupTracker. play() puts a
+// stone for the side to move, takes off any enemy group it leaves
+// without liberties, and refuses suicide, retaking a ko at once, and,
+// with superko, any move that would bring back an earlier position
+// (positional superko: the same stones, whoever is to move). A move is
+// legal if it has an empty neighbour, joins a friendly group that has
+// another liberty, or captures; legalMoves() finds all of them at once
+// from the groups' liberties.
+
+template<size_t NRows, size_t NCols> class Game {
+public:
+  typedef BoardModel<NRows, NCols> BoardModelRC;
+  typedef GroupTracker<NRows, NCols> GroupTrackerRC;
+  typedef PaddedBoardSet<NRows, NCols> BoardSetRC;
+  typedef Zobrist<NRows, NCols> ZobristRC;
+
+  explicit Game(bool _superko = false, bool keepCounts = false) :
+    board (keepCounts),
+    tracker (),
+    toMove (Black),
+    hasKo (false),
+    koRow (0),
+    koCol (0),
+    superko (_superko),
+    history ()
+  {
+    history.insert(board.hash());
+  }
+
+  BoardModelRC const &position() const {
+    return board;
+  }
+  GroupTrackerRC const &groups() const {
+    return tracker;
+  }
+  Point sideToMove() const {
+    return toMove;
+  }
+
+  bool isLegal(size_t i, size_t j) const {
+    if (board.pointAt(i, j) != Empty || (hasKo && i == koRow && j == koCol)) {
+      return false;
+    }
+
+    bool hasLiberty = false;
+    forEachNeighbour(i, j, [&](int ni, int nj) {
+      Point p = board.pointAt(ni, nj);
+      if (p == Empty) {
+	hasLiberty = true;
+      } else if (p == toMove) {
+	hasLiberty = hasLiberty || 1 < tracker.liberties(ni, nj);
+      } else if (p == opponent(toMove)) {
+	hasLiberty = hasLiberty || tracker.liberties(ni, nj) == 1;
+      }
+    });
+    return hasLiberty && !(superko && history.count(hashAfter(i, j)));
+  }
+
+  // Every legal move for the side to move: the empty points next to an
+  // empty point, the liberties of friendly groups with more than one,
+  // and the last liberty of enemy groups; less the ko, and, checked a
+  // point at a time, superko.
+
+  BoardSetRC legalMoves() const {
+    BoardSetRC const &empty = board[Empty];
+    BoardSetRC moves = empty & (empty.shifted(N) | empty.shifted(S) | empty.shifted(E) | empty.shifted(W));
+
+    (board[Black] | board[White]).forEach([&](size_t i, size_t j) {
+      if (tracker.group(i, j) != (i * NCols) + j) {
+	return;
+      }
+      size_t n = tracker.liberties(i, j);
+      if (board.pointAt(i, j) == toMove ? 1 < n : n == 1) {
+	moves |= tracker.libertiesOf(i, j);
       }
+    });
+
+    if (hasKo) {
+      moves(koRow, koCol) = false;
+    }
+    if (superko) {
+      BoardSetRC repeats;
+      moves.forEach([&](size_t i, size_t j) {
+	if (history.count(hashAfter(i, j))) {
+	  repeats(i, j) = true;
+	}
+      });
+      moves.andNot(repeats);
     }
+    return moves;
   }
 
-  void fprint(FILE *out) const {
-    fprintf(out, "Groups = {\n");
-    for (Point p = Illegal; p < EoPoint; p = Point(size_t(p) + 1)) {
-      fprintf(out, "  [%u] {\n", unsigned(p));
-      for (auto g = (*this)[p].begin(); g != (*this)[p].end(); g++) {
-	fprintf(out, "    ");
-	(*g)->fprint(out);
-	fprintf(out, "\n");
+  // Play the side to move at (i, j), if that's legal. Returns whether
+  // it was.
+
+  bool play(size_t i, size_t j) {
+    if (!isLegal(i, j)) {
+      return false;
+    }
+
+    Point enemy = opponent(toMove);
+    board.put(i, j, toMove);
+    tracker.place(board, i, j);
+
+    size_t nCaptured = 0;
+    forEachNeighbour(i, j, [&](int ni, int nj) {
+      if (board.pointAt(ni, nj) == enemy && tracker.liberties(ni, nj) == 0) {
+	nCaptured += tracker.stones(ni, nj);
+	koRow = ni;
+	koCol = nj;
+	tracker.remove(board, ni, nj);
       }
-      fprintf(out, "  }\n");
+    });
+
+    // A single stone that took a single stone, and has only the point
+    // it took for a liberty, could be taken straight back.
+
+    hasKo = nCaptured == 1 && tracker.stones(i, j) == 1 && tracker.liberties(i, j) == 1;
+    toMove = enemy;
+    if (superko) {
+      history.insert(board.hash());
     }
-    fprintf(out, "}\n");
+    return true;
   }
 
-  rarray<Group<NRows, NCols> *, NRows, NCols> pointGroups;
+  void pass() {
+    hasKo = false;
+    toMove = opponent(toMove);
+  }
+
+private:
+  static Point opponent(Point p) {
+    return p == Black ? White : Black;
+  }
+
+  // Call f(row, col) for the four neighbours of (i, j), on the board or
+  // not: off the board, the board reads Illegal.
+
+  template<typename F> static void forEachNeighbour(int i, int j, F f) {
+    f(i - 1, j);
+    f(i + 1, j);
+    f(i, j - 1);
+    f(i, j + 1);
+  }
+
+  // The hash of the position after the side to move plays at (i, j):
+  // the new stone in, and any enemy groups in atari next to it out.
+
+  uint64_t hashAfter(size_t i, size_t j) const {
+    ZobristRC const &keys = ZobristRC::instance();
+    Point enemy = opponent(toMove);
+
+    uint64_t hash = board.hash() ^ keys.stone((i * NCols) + j, toMove == White);
+
+    array<size_t, 4> taken;
+    size_t nTaken = 0;
+    forEachNeighbour(i, j, [&](int ni, int nj) {
+      if (board.pointAt(ni, nj) != enemy || tracker.liberties(ni, nj) != 1) {
+	return;
+      }
+      size_t g = tracker.group(ni, nj);
+      if (std::find(taken.begin(), taken.begin() + nTaken, g) != taken.begin() + nTaken) {
+	return;
+      }
+      taken[nTaken++] = g;
+      tracker.forEachStone(ni, nj, [&](size_t si, size_t sj) { hash ^= keys.stone((si * NCols) + sj, enemy == White); });
+    });
+    return hash;
+  }
+
+  BoardModelRC board;
+  GroupTrackerRC tracker;
+  Point toMove;
+  bool hasKo;
+  size_t koRow;
+  size_t koCol;
+  bool superko;
+  set<uint64_t> history;
 };
 
 int main(int argc, char const *argv[])
@@ -593,17 +1022,23 @@ int main(int argc, char const *argv[])
   ARGV0 = argv[0];
 
   // BoardModel board;
-  BoardModel<19, 19> board;
+  Game<19, 19> game(false, true);
+  BoardModel<19, 19> const &board = game.position();
 
-  size_t nStones = ((NRows * NCols) * 8) / 10;
+  size_t nMoves = ((NRows * NCols) * 8) / 10;
   int i = rand() % NRows;
   int j = rand() % NCols;
 
-  BoardSet<NRows, NCols> filled;
-  Point who = Black;
+  for (size_t n = 0; n < nMoves; n += 1) {
+    Point who = game.sideToMove();
+
+    if (game.legalMoves().none()) {
+      fprintf(stdout, "%c[]\n", who == Black ? 'B' : 'W');
+      game.pass();
+      continue;
+    }
 
-  for (size_t n = 0; n < nStones; n += 1) {
-    while (!board.isEmpty(i, j)) {
+    while (!game.isLegal(i, j)) {
       int iNew = i + ((rand() % 8) - 4);
       if (iNew < 0 || NRows <= iNew) {
 	continue;
@@ -625,13 +1060,12 @@ int main(int argc, char const *argv[])
 	    'a' + j
 	   );
 
-    board.put(i, j, who);
+    game.play(i, j);
+    assert(game.groups().liberties(i, j) == board.liberties(game.groups().stonesOf(i, j)).count());
 
     board.fprint(stdout);
 
-    BoardNeighborhoodCounts<19, 19> counts;
-    counts.Fill(board);
-    counts.fprint(stdout);
+    board.counts().fprint(stdout);
 
     Groups<19, 19> groups;
     groups.Fill(board);
@@ -640,8 +1074,6 @@ int main(int argc, char const *argv[])
     BoardPatterns<19, 19> patterns;
     patterns.Fill(board);
     patterns.fprint(stdout);
-
-    who = (who == Black) ? White : Black;
   }
 
   return 0;
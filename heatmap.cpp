@@ -0,0 +1,255 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+using std::vector;
+
+#include "board.h"
+#include "line.h"
+#include "sgfreader.h"
+
+// Reads SGF files (or stdin) and prints, for the final position of
+// every game in them, the number of open lines through each point: the
+// heatmap r4 keeps in Board::counts(), for games of any size. Each
+// game's moves are played out, captures and all, to find that position.
+//
+//	heatmap [-g] [file.sgf ...]
+//
+// Each game's size comes from its SZ property. 9x9, 13x13 and 19x19,
+// the sizes played, go to a Board built for that size, kept for the
+// whole run. Any other size, up to SGF's 52x52, goes to a generic,
+// slower loop that draws each line as it needs it. -g sends every game
+// there, to check one against the other.
+
+// The heatmap of a position on an nRows x nCols board, whatever its
+// size, and the stones on it, for printing.
+
+struct Heatmap {
+  Heatmap(size_t _nRows, size_t _nCols) :
+    nRows (_nRows),
+    nCols (_nCols),
+    counts (_nRows * _nCols, 0),
+    states (_nRows * _nCols, Empty)
+  {
+  }
+
+  void fprint(FILE *out) const {
+    fprintf(out, " ");
+    for (size_t j = 0; j < nCols; j += 1) {
+      fprintf(out, "       %c", char(j < 26 ? j + 'a' : (j - 26) + 'A'));
+    }
+    fprintf(out, "\n");
+    for (size_t i = 0; i < nRows; i += 1) {
+      fprintf(out, "%c", char(i < 26 ? i + 'a' : (i - 26) + 'A'));
+      for (size_t j = 0; j < nCols; j += 1) {
+	State s = states[(i * nCols) + j];
+	fprintf(out, " %5zu %c", counts[(i * nCols) + j], s == Black ? '@' : (s == White ? 'O' : '.'));
+      }
+      fprintf(out, "\n");
+    }
+  }
+
+  size_t nRows;
+  size_t nCols;
+  vector<size_t> counts;
+  vector<State> states;
+};
+
+// The stones left at the end of game, point by point. Each move takes
+// off the opposing groups it leaves without a liberty, then its own
+// group, if that has none left (suicide, where the rules allow it).
+// Setup stones take nothing off, and replace whatever they land on.
+
+vector<State> finalPosition(SgfGame const &game)
+{
+  size_t const nRows = game.nRows;
+  size_t const nCols = game.nCols;
+
+  vector<State> states(nRows * nCols, Empty);
+
+  // Take off the group at p, if it has no liberty.
+
+  vector<size_t> group;
+  vector<bool> inGroup(nRows * nCols, false);
+  auto capture = [&](size_t p) {
+    State s = states[p];
+    bool isFree = false;
+
+    group.assign(1, p);
+    inGroup[p] = true;
+    for (size_t g = 0; g < group.size(); g += 1) {
+      size_t i = group[g] / nCols;
+      size_t j = group[g] % nCols;
+      size_t const next[] = {
+	0 < i ? group[g] - nCols : group[g],
+	i + 1 < nRows ? group[g] + nCols : group[g],
+	0 < j ? group[g] - 1 : group[g],
+	j + 1 < nCols ? group[g] + 1 : group[g]
+      };
+      for (auto q : next) {
+	if (states[q] == Empty) {
+	  isFree = true;
+	} else if (states[q] == s && !inGroup[q]) {
+	  inGroup[q] = true;
+	  group.push_back(q);
+	}
+      }
+    }
+    for (auto q : group) {
+      inGroup[q] = false;
+      if (!isFree) {
+	states[q] = Empty;
+      }
+    }
+  };
+
+  for (auto const &stone : game.stones) {
+    assert(stone.row < nRows && stone.col < nCols);
+
+    size_t p = (stone.row * nCols) + stone.col;
+    State s = stone.isWhite ? White : Black;
+
+    states[p] = s;
+    if (!stone.isMove) {
+      continue;
+    }
+    size_t const next[] = {
+      0 < stone.row ? p - nCols : p,
+      stone.row + 1 < nRows ? p + nCols : p,
+      0 < stone.col ? p - 1 : p,
+      stone.col + 1 < nCols ? p + 1 : p
+    };
+    for (auto q : next) {
+      if (states[q] != Empty && states[q] != s) {
+	capture(q);
+      }
+    }
+    capture(p);
+  }
+  return states;
+}
+
+// The fast path: one Board per size, loaded with a game's stones in one
+// putMany(), read, and cleared again by undo().
+
+template<size_t N> Heatmap heatmapOf(SgfGame const &game)
+{
+  typedef Board<N, N> BoardRC;
+  typedef BoardLocation<N, N> LocationRC;
+
+  static BoardRC board;
+
+  vector<State> const states = finalPosition(game);
+
+  vector<LocationRC> stones;
+  vector<State> colors;
+  for (size_t l = 0; l < N * N; l += 1) {
+    if (states[l] != Empty) {
+      stones.push_back(LocationRC(l));
+      colors.push_back(states[l]);
+    }
+  }
+  bool placed = board.putMany(stones, colors) != 0;
+
+  Heatmap heatmap(N, N);
+  for (size_t l = 0; l < N * N; l += 1) {
+    heatmap.counts[l] = board.counts()[l];
+    heatmap.states[l] = board[l].is(Black) ? Black : (board[l].is(White) ? White : Empty);
+  }
+
+  if (placed) {
+    board.undo();
+  }
+  return heatmap;
+}
+
+// The generic path: the same counts, from every src..dst line drawn
+// afresh, with no tables to build, so it works for any size. Bresenham
+// doesn't depend on the board's size, so any Line will do to draw them.
+
+Heatmap genericHeatmapOf(SgfGame const &game)
+{
+  typedef Line<SgfReader::maxSize, SgfReader::maxSize> LineRC;
+
+  size_t const nRows = game.nRows;
+  size_t const nCols = game.nCols;
+  size_t const nPoints = nRows * nCols;
+
+  Heatmap heatmap(nRows, nCols);
+  heatmap.states = finalPosition(game);
+
+  vector<size_t> pixels;
+  pixels.reserve(nRows < nCols ? nCols : nRows);
+
+  for (size_t src = 0; src < nPoints; src += 1) {
+    for (size_t dst = 0; dst < nPoints; dst += 1) {
+      if (src == dst) {
+	continue;
+      }
+
+      pixels.clear();
+      LineRC::bresenham(src / nCols, src % nCols, dst / nCols, dst % nCols,
+			[&](int x, int y) { pixels.push_back((size_t(x) * nCols) + size_t(y)); });
+
+      // A stone blocks the line anywhere but at its ends.
+
+      bool isOpen = true;
+      for (size_t k = 1; isOpen && k + 1 < pixels.size(); k += 1) {
+	isOpen = heatmap.states[pixels[k]] == Empty;
+      }
+      if (isOpen) {
+	for (auto const &q : pixels) {
+	  heatmap.counts[q] += 1;
+	}
+      }
+    }
+  }
+  return heatmap;
+}
+
+Heatmap heatmapOf(SgfGame const &game, bool generic)
+{
+  if (!generic && game.nRows == game.nCols) {
+    switch (game.nRows) {
+    case 9: return heatmapOf<9>(game);
+    case 13: return heatmapOf<13>(game);
+    case 19: return heatmapOf<19>(game);
+    }
+  }
+  return genericHeatmapOf(game);
+}
+
+int main(int argc, char const *argv[])
+{
+  bool generic = 1 < argc && strcmp(argv[1], "-g") == 0;
+  int first = generic ? 2 : 1;
+
+  vector<SgfGame> games;
+  if (argc <= first) {
+    if (!SgfReader::read(stdin, "<stdin>", games)) {
+      return 1;
+    }
+  }
+  for (int a = first; a < argc; a += 1) {
+    FILE *in = fopen(argv[a], "r");
+    if (!in) {
+      fprintf(stderr, "%s: can't open\n", argv[a]);
+      return 1;
+    }
+    bool ok = SgfReader::read(in, argv[a], games);
+    fclose(in);
+    if (!ok) {
+      return 1;
+    }
+  }
+
+  for (size_t g = 0; g < games.size(); g += 1) {
+    fprintf(stdout, "game %zu: %zux%zu, %zu stones\n", g, games[g].nRows, games[g].nCols, games[g].stones.size());
+    heatmapOf(games[g], generic).fprint(stdout);
+    fprintf(stdout, "\n");
+  }
+  return 0;
+}
@@ -1,7 +1,17 @@
 #ifndef LINE_H
 #define LINE_H
 
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+
+#include <array>
+using std::array;
+
+#include <iterator>
+
+#include <type_traits>
+using std::conditional;
 
 #include <vector>
 using std::vector;
@@ -17,91 +27,98 @@ template <size_t NRows, size_t NCols> struct Line: public vector<BoardLocation<N
 
   Line() : lineId (), reflections (0) { }
 
-  // Line(Location<NRows, NCols> _src, int x1, int y1) :
-  //   src (_src),
-  //   dst (_src),
-  //   reflections (0)
-  // {
-  //   // Setup Bresenham's line drawing algorithm.
-  //
-  //   int vx0 = src.row();
-  //   int vy0 = src.col();
-  //   int ax0 = vx0;
-  //   int ay0 = vy0;
-  //
-  //   int dx = abs(x1 - vx0);
-  //   int vsx = vx0 < x1 ? +1 : -1;
-  //   int asx = vsx;
-  //   int dy = abs(y1 - vy0);
-  //   int vsy = vy0 < y1 ? +1 : -1;
-  //   int asy = vsy;
-  //   int err = dx - dy;
-  //
-  //   for (push_back(Location<NRows, NCols>(ax0, ay0));
-  // 	 !(vx0 == x1 && vy0 == y1);
-  // 	 push_back(Location<NRows, NCols>(ax0, ay0))
-  // 	)
-  //   {
-  //     bool reflected = false;
-  //     int e2 = 2 * err;
-  //     if (e2 > -dy) {
-  // 	err -= dy;
-  // 	vx0 += vsx;
-  // 	ax0 += asx;
-  //
-  // 	if (ax0 < 0) {
-  // 	  reflected = true;
-  // 	  ax0 = -ax0;
-  // 	  asx = -asx;
-  // 	} else if (NRows <= ax0) {
-  // 	  reflected = true;
-  // 	  ax0 = NRows - 2;
-  // 	  asx = -asx;
-  // 	}
-  //     }
-  //     if (e2 < dx) {
-  // 	err += dx;
-  // 	vy0 += vsy;
-  // 	ay0 += asy;
-  //
-  // 	if (ay0 < 0) {
-  // 	  reflected = true;
-  // 	  ay0 = -ay0;
-  // 	  asy = -asy;
-  // 	} else if (NCols <= ay0) {
-  // 	  reflected = true;
-  // 	  ay0 = NCols - 2;
-  // 	  asy = -asy;
-  // 	}
-  //     }
-  //     if (reflected) {
-  // 	reflections += 1;
-  //     }
-  //   }
-  //   dst = this->back();
-  // }
+  // A line reflected off the edges of the board: Bresenham's line from
+  // src to (x1, y1), a point that may lie off the board, in the plane
+  // tiled by mirror images of the board (see fold()), folded back onto
+  // the board pixel by pixel. A line that crosses a pixel twice keeps
+  // it once, where it first reached it; reflections counts the edges
+  // it bounced off on the way (see bounces()).
+
+  Line(LocationRC src, int x1, int y1) :
+    lineId (src, LocationRC(fold(x1, NRows), fold(y1, NCols))),
+    reflections (bounces(src.row(), x1, NRows) + bounces(src.col(), y1, NCols))
+  {
+    drawReflected(src.row(), src.col(), x1, y1, std::back_inserter(*this));
+  }
   Line(LineIdRC _lineId) :
     lineId(_lineId),
     reflections (0)
   {
-    // Setup Bresenham's line drawing algorithm.
+    draw(lineId, std::back_inserter(*this));
+  }
+
+  // Rasterize lineId, writing each BoardLocation, src to dst
+  // inclusive, through out.
 
-    int x0 = lineId.src.row();
-    int y0 = lineId.src.col();
-    int x1 = lineId.dst.row();
-    int y1 = lineId.dst.col();
+  template<typename OutputIt> static OutputIt draw(LineIdRC const &lineId, OutputIt out) {
+    bresenham(lineId.src.row(), lineId.src.col(), lineId.dst.row(), lineId.dst.col(),
+	      [&](int x, int y) { *out++ = LocationRC(x, y); });
+    return out;
+  }
+
+  // Rasterize the reflected line from (x0, y0) on the board to (x1, y1)
+  // in the unfolded plane, writing each BoardLocation once, in the order
+  // first reached, through out.
+
+  template<typename OutputIt> static OutputIt drawReflected(int x0, int y0, int x1, int y1, OutputIt out) {
+    vector<bool> seen(NRows * NCols, false);
+    bresenham(x0, y0, x1, y1,
+	      [&](int x, int y) {
+		LocationRC l(size_t(fold(x, NRows)), size_t(fold(y, NCols)));
+		if (!seen[l]) {
+		  seen[l] = true;
+		  *out++ = l;
+		}
+	      });
+    return out;
+  }
+
+  // Whether the reflected line from (x0, y0) to (x1, y1) reaches the
+  // board point its end folds to before the end itself, as one folding
+  // straight back along an edge does. Such a line's end isn't its last
+  // new pixel, and it passes its dst mid-path.
+
+  static bool passesEnd(int x0, int y0, int x1, int y1) {
+    int r = fold(x1, NRows);
+    int c = fold(y1, NCols);
+    bool passes = false;
+    bresenham(x0, y0, x1, y1,
+	      [&](int x, int y) {
+		passes = passes || (!(x == x1 && y == y1) && fold(x, NRows) == r && fold(y, NCols) == c);
+	      });
+    return passes;
+  }
 
-    int dx = abs(x1 - x0);
+  // Reflecting the board about its edges, again and again, tiles the
+  // plane with period 2(n - 1) along a side of n points; fold() maps a
+  // coordinate in that plane back to the board, and bounces() counts
+  // the edges, k(n - 1), strictly between x0 and x1. A line that ends on
+  // an edge hasn't bounced off it.
+
+  static constexpr int fold(int x, size_t n) {
+    int period = 2 * (int(n) - 1);
+    int m = ((x % period) + period) % period;
+    return m < int(n) ? m : period - m;
+  }
+  static constexpr size_t bounces(int x0, int x1, size_t n) {
+    int lo = x0 < x1 ? x0 : x1;
+    int hi = x0 < x1 ? x1 : x0;
+    return lo == hi ? 0 : size_t(floorDiv(hi - 1, int(n) - 1) - floorDiv(lo, int(n) - 1));
+  }
+
+  // Bresenham's line drawing algorithm, from (x0, y0) to (x1, y1)
+  // inclusive, calling plot(x, y) for each pixel. It is constexpr, so
+  // the very same code also generates lines at compile time (see
+  // staticlinetable.h).
+
+  template<typename Plot> static constexpr void bresenham(int x0, int y0, int x1, int y1, Plot plot) {
+    int dx = x0 < x1 ? x1 - x0 : x0 - x1;
     int sx = x0 < x1 ? +1 : -1;
-    int dy = abs(y1 - y0);
+    int dy = y0 < y1 ? y1 - y0 : y0 - y1;
     int sy = y0 < y1 ? +1 : -1;
     int err = dx - dy;
 
-    for (VectorOfLocationRC::push_back(LocationRC(x0, y0));
-  	 !(x0 == x1 && y0 == y1);
-  	 VectorOfLocationRC::push_back(LocationRC(x0, y0))
-  	)
-    {
+    for (plot(x0, y0); !(x0 == x1 && y0 == y1); plot(x0, y0)) {
       int e2 = 2 * err;
       if (e2 > -dy) {
   	err -= dy;
@@ -113,6 +130,22 @@ template <size_t NRows, size_t NCols> struct Line: public vector<BoardLocation<N
       }
     }
   }
+
+  // Bresenham emits exactly one pixel per step along the major axis.
+
+  static constexpr size_t length(int x0, int y0, int x1, int y1) {
+    int dx = x0 < x1 ? x1 - x0 : x0 - x1;
+    int dy = y0 < y1 ? y1 - y0 : y0 - y1;
+    return size_t(dx < dy ? dy : dx) + 1;
+  }
+  static size_t length(LineIdRC const &lineId) {
+    return length(lineId.src.row(), lineId.src.col(), lineId.dst.row(), lineId.dst.col());
+  }
+
+  static constexpr int floorDiv(int a, int b) {
+    return (a / b) - ((a % b) != 0 && a < 0 ? 1 : 0);
+  }
+
   bool operator==(Line const &that) const {
     return lineId == that.lineId && reflections == that.reflections;
   }
@@ -136,4 +169,88 @@ template <size_t NRows, size_t NCols> struct Line: public vector<BoardLocation<N
   size_t reflections;
 };
 
+// The smallest unsigned type that holds every offset on the board: a
+// pixel packed into one byte up to 16x16, and two up to 256x256.
+
+template<size_t NRows, size_t NCols> struct PackedPixel {
+  typedef typename conditional<(NRows * NCols <= 0x100), uint8_t,
+			       typename conditional<(NRows * NCols <= 0x10000), uint16_t, uint32_t>::type
+			      >::type type;
+};
+
+// Walks packed pixels, yielding each as a BoardLocation.
+
+template<size_t NRows, size_t NCols> class PackedPixelIterator {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  PackedPixelIterator(Pixel const *_p) : p (_p) { }
+  LocationRC operator*() const { return LocationRC(size_t(*p)); }
+  PackedPixelIterator &operator++() {
+    ++p;
+    return *this;
+  }
+  bool operator==(PackedPixelIterator const &that) const { return p == that.p; }
+  bool operator!=(PackedPixelIterator const &that) const { return p != that.p; }
+
+private:
+  Pixel const *p;
+};
+
+// A run of packed pixels, such as one line of a line table.
+
+template<size_t NRows, size_t NCols> struct PackedPixels {
+  typedef PackedPixelIterator<NRows, NCols> PackedPixelIteratorRC;
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  PackedPixelIteratorRC begin() const { return PackedPixelIteratorRC(first); }
+  PackedPixelIteratorRC end() const { return PackedPixelIteratorRC(last); }
+  size_t size() const { return size_t(last - first); }
+
+  Pixel const *first;
+  Pixel const *last;
+};
+
+// A straight line like Line, but packed: its pixels sit inline, one
+// PackedPixel each, in room for the longest line on the board, so a
+// PackedLine is one small block with no heap allocation of its own.
+
+template<size_t NRows, size_t NCols> struct PackedLine {
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef PackedPixelIterator<NRows, NCols> PackedPixelIteratorRC;
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  static size_t const capacity = NRows < NCols ? NCols : NRows;
+
+  PackedLine() : lineId (), n (0), pixels () { }
+  explicit PackedLine(LineIdRC _lineId) :
+    lineId (_lineId),
+    n (0),
+    pixels ()
+  {
+    n = draw(lineId, &pixels[0]);
+  }
+
+  // Rasterize lineId into pixels, returning how many it wrote.
+
+  static size_t draw(LineIdRC const &lineId, Pixel *pixels) {
+    size_t k = 0;
+    LineRC::bresenham(lineId.src.row(), lineId.src.col(), lineId.dst.row(), lineId.dst.col(),
+		      [&](int x, int y) { pixels[k++] = Pixel((x * NCols) + y); });
+    return k;
+  }
+
+  PackedPixelIteratorRC begin() const { return PackedPixelIteratorRC(&pixels[0]); }
+  PackedPixelIteratorRC end() const { return PackedPixelIteratorRC(&pixels[0] + n); }
+  size_t size() const { return n; }
+  LocationRC operator[](size_t i) const { return LocationRC(size_t(pixels[i])); }
+
+  LineIdRC lineId;
+  size_t n;
+  array<Pixel, capacity> pixels;
+};
+
 #endif // LINE_H
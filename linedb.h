@@ -0,0 +1,256 @@
+#ifndef LINEDB_H
+#define LINEDB_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lineset.h"
+
+// A precomputed line database: the LineTable for one board size and
+// LineMode, the lines through every intersection and (for Directed
+// tables) the BetweenMasks, serialised by mklinedb into one versioned
+// binary file. LineTable and BetweenMasks map that file read-only when
+// they find one, so every process shares one page-cache copy, and fall
+// back to building their data when they don't.
+//
+// The files live in $LINEDB, or in the current directory, and are named
+// linedb-<rows>x<cols>[u].bin, where u marks an Undirected table.
+
+enum LineDbSection {
+  LineDbOffsets,		// uint32_t, nLines + 1
+  LineDbPixels,			// the LineTable's Pixel, nPixels
+  LineDbMembership,		// LineSet words, nPoints rows of them
+  LineDbBetweenMasks,		// BoardSet, nLines (Directed only)
+
+  EoLineDbSection
+};
+
+struct LineDbHeader {
+  static uint32_t const currentVersion = 2;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t nRows;
+  uint32_t nCols;
+  uint32_t mode;
+  uint32_t pixelSize;
+  uint32_t maskSize;
+  uint64_t nLines;
+  uint64_t sections[EoLineDbSection][2];	// Byte offset, byte size.
+};
+
+class LineDb {
+public:
+  // The mapped database matching a table's shape, or 0 if there is no
+  // such file, or it was written for a different shape or version.
+  // Each file is mapped at most once, and stays mapped, but every
+  // caller's shape is checked against it. Tables may be built from
+  // several threads at once, so the files mapped so far are locked.
+
+  static LineDb const *find(size_t nRows, size_t nCols, unsigned mode, size_t pixelSize, size_t maskSize, size_t nLines) {
+    static mutex lock;
+    static map<string, LineDb const *> opened;
+
+    if (bypassed()) {
+      return 0;
+    }
+
+    lock_guard<mutex> locked(lock);
+
+    string path = pathFor(nRows, nCols, mode);
+    auto o = opened.find(path);
+    LineDb const *db = o != opened.end() ? o->second : (opened[path] = open(path.c_str()));
+
+    if (db) {
+      LineDbHeader const &h = db->header();
+      if (h.nRows != nRows || h.nCols != nCols || h.mode != mode ||
+	  h.pixelSize != pixelSize || h.maskSize != maskSize || h.nLines != nLines
+	 ) {
+	fprintf(stderr, "LineDb: %s doesn't match this build; ignoring it\n", path.c_str());
+	return 0;
+      }
+    }
+    return db;
+  }
+
+  // Whether find() ignores every database, so tables are built afresh,
+  // as mklinedb needs them to be.
+
+  static bool &bypassed() {
+    static bool bypass = false;
+    return bypass;
+  }
+
+  static string pathFor(size_t nRows, size_t nCols, unsigned mode) {
+    char name[64];
+    snprintf(name, sizeof(name), "linedb-%zux%zu%s.bin", nRows, nCols, mode ? "u" : "");
+
+    char const *dir = getenv("LINEDB");
+    return dir && *dir ? string(dir) + "/" + name : string(name);
+  }
+
+  LineDbHeader const &header() const {
+    return *reinterpret_cast<LineDbHeader const *>(base);
+  }
+  void const *section(LineDbSection s) const {
+    return sectionSize(s) ? base + header().sections[s][0] : 0;
+  }
+  size_t sectionSize(LineDbSection s) const {
+    return size_t(header().sections[s][1]);
+  }
+
+  // Write a database from header (whose magic, version and sections
+  // are filled in here) and the contents of each section.
+
+  static bool write(char const *path, LineDbHeader header, void const *data[EoLineDbSection], size_t const size[EoLineDbSection]) {
+    memcpy(header.magic, magic(), sizeof(header.magic));
+    header.version = LineDbHeader::currentVersion;
+
+    uint64_t at = align(sizeof(header));
+    for (size_t s = 0; s < EoLineDbSection; s += 1) {
+      header.sections[s][0] = at;
+      header.sections[s][1] = size[s];
+      at = align(at + size[s]);
+    }
+
+    // Write a new file beside the old one and rename it into place, so
+    // a process still mapping the old file keeps a whole copy of it.
+
+    string temp = string(path) + ".tmp";
+    FILE *out = fopen(temp.c_str(), "wb");
+    if (!out) {
+      return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    for (size_t s = 0; ok && s < EoLineDbSection; s += 1) {
+      ok = fseek(out, long(header.sections[s][0]), SEEK_SET) == 0 && fwrite(data[s], 1, size[s], out) == size[s];
+    }
+    ok = fseek(out, long(at) - 1, SEEK_SET) == 0 && fputc(0, out) != EOF && ok;
+    ok = fclose(out) == 0 && ok && rename(temp.c_str(), path) == 0;
+    if (!ok) {
+      unlink(temp.c_str());
+    }
+    return ok;
+  }
+
+private:
+  LineDb(char const *_base, size_t _size) : base (_base), size (_size) { }
+
+  static char const *magic() { return "LINEDB\0"; }
+  static uint64_t align(uint64_t n) { return (n + 63) & ~uint64_t(63); }
+
+  static LineDb const *open(char const *path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return 0;
+    }
+
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && sizeof(LineDbHeader) <= size_t(st.st_size)) {
+      base = mmap(0, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+      return 0;
+    }
+
+    LineDb *db = new LineDb(static_cast<char const *>(base), size_t(st.st_size));
+    LineDbHeader const &h = db->header();
+    bool ok = memcmp(h.magic, magic(), sizeof(h.magic)) == 0 && h.version == LineDbHeader::currentVersion;
+    for (size_t s = 0; ok && s < EoLineDbSection; s += 1) {
+      ok = h.sections[s][1] <= db->size && h.sections[s][0] <= db->size - h.sections[s][1];
+    }
+    if (!ok || !db->isConsistent()) {
+      fprintf(stderr, "LineDb: %s is not a whole version %u line database; ignoring it\n", path, LineDbHeader::currentVersion);
+      release(db);
+      return 0;
+    }
+    return db;
+  }
+
+  // Whether the header's line count is the one its board and mode call
+  // for, every section is the size that calls for (with BetweenMasks
+  // only for Directed tables, mode 0), the offsets run, in order, over
+  // exactly the pixels, every pixel is on the board, and no LineSet has
+  // a bit set past the last line. Tables index Board and LineSets
+  // with all of these unchecked, so a file that fails any one is
+  // rebuilt from scratch instead.
+
+  bool isConsistent() const {
+    LineDbHeader const &h = header();
+    uint64_t nPoints = uint64_t(h.nRows) * h.nCols;
+
+    if (h.nRows == 0 || 0xffff < h.nRows || h.nCols == 0 || 0xffff < h.nCols || 1 < h.mode ||
+	size / sizeof(uint32_t) <= h.nLines || !(h.pixelSize == 1 || h.pixelSize == 2 || h.pixelSize == 4) || size < h.maskSize ||
+	h.nLines != (nPoints * (nPoints - 1)) / (h.mode == 0 ? 1 : 2)
+       ) {
+      return false;
+    }
+    if (sectionSize(LineDbOffsets) != (h.nLines + 1) * sizeof(uint32_t) ||
+	sectionSize(LineDbMembership) != nPoints * LineSet::wordsFor(h.nLines) * sizeof(LineSet::Word) ||
+	sectionSize(LineDbBetweenMasks) != (h.mode == 0 ? h.nLines * h.maskSize : 0) ||
+	h.sections[LineDbOffsets][0] % sizeof(uint32_t) != 0
+       ) {
+      return false;
+    }
+
+    uint32_t const *offsets = static_cast<uint32_t const *>(section(LineDbOffsets));
+    for (uint64_t id = 0; id < h.nLines; id += 1) {
+      if (offsets[id + 1] < offsets[id]) {
+	return false;
+      }
+    }
+    if (offsets[0] != 0 || sectionSize(LineDbPixels) != uint64_t(offsets[h.nLines]) * h.pixelSize) {
+      return false;
+    }
+
+    char const *pixels = static_cast<char const *>(section(LineDbPixels));
+    for (uint64_t k = 0; k < offsets[h.nLines]; k += 1) {
+      uint32_t pixel = 0;
+      memcpy(&pixel, pixels + (k * h.pixelSize), h.pixelSize);	// Little-endian, as written.
+      if (nPoints <= pixel) {
+	return false;
+      }
+    }
+
+    size_t const nWords = LineSet::wordsFor(h.nLines);
+    size_t const nSpare = (nWords * LineSet::bitsPerWord) - h.nLines;
+    LineSet::Word const *membership = static_cast<LineSet::Word const *>(section(LineDbMembership));
+    for (uint64_t l = 0; nSpare != 0 && l < nPoints; l += 1) {
+      if (membership[(l * nWords) + nWords - 1] >> (LineSet::bitsPerWord - nSpare) != 0) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // Unmap a database open() returned, and free it.
+
+  static void release(LineDb const *db) {
+    munmap(const_cast<char *>(db->base), db->size);
+    delete db;
+  }
+
+  char const *base;
+  size_t size;
+};
+
+#endif // LINEDB_H
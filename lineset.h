@@ -0,0 +1,95 @@
+#ifndef LINESET_H
+#define LINESET_H
+
+#include <cstdint>
+
+#include <algorithm>
+
+#include <vector>
+using std::vector;
+
+// A dense set of line indices, one bit per line in the LineTable, kept
+// in 64-bit words so whole sets combine a word at a time.
+
+class LineSet {
+public:
+  typedef uint64_t Word;
+
+  static size_t const bitsPerWord = 64;
+
+  explicit LineSet(size_t nBits) : words(wordsFor(nBits), 0) { }
+
+  static size_t wordsFor(size_t nBits) {
+    return (nBits + bitsPerWord - 1) / bitsPerWord;
+  }
+
+  // The words themselves, for saving a set and loading it back.
+
+  Word const *data() const {
+    return &words[0];
+  }
+  void assign(Word const *that) {
+    std::copy(that, that + words.size(), words.begin());
+  }
+
+  bool test(size_t i) const {
+    return (words[i / bitsPerWord] >> (i % bitsPerWord)) & 1;
+  }
+  void set(size_t i) {
+    words[i / bitsPerWord] |= Word(1) << (i % bitsPerWord);
+  }
+  void reset(size_t i) {
+    words[i / bitsPerWord] &= ~(Word(1) << (i % bitsPerWord));
+  }
+
+  size_t count() const {
+    size_t n = 0;
+    for (size_t w = 0; w < words.size(); w += 1) {
+      n += size_t(__builtin_popcountll(words[w]));
+    }
+    return n;
+  }
+  bool none() const {
+    for (size_t w = 0; w < words.size(); w += 1) {
+      if (words[w]) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  void clear() {
+    std::fill(words.begin(), words.end(), Word(0));
+  }
+
+  // *this |= that, a word at a time.
+
+  void orWith(LineSet const &that) {
+    for (size_t w = 0; w < words.size(); w += 1) {
+      words[w] |= that.words[w];
+    }
+  }
+
+  // *this &= ~that, a word at a time.
+
+  void andNot(LineSet const &that) {
+    for (size_t w = 0; w < words.size(); w += 1) {
+      words[w] &= ~that.words[w];
+    }
+  }
+
+  // Call f(i) for every i in the set, in increasing order.
+
+  template<typename F> void forEach(F f) const {
+    for (size_t w = 0; w < words.size(); w += 1) {
+      for (Word bits = words[w]; bits; bits &= bits - 1) {
+	f((w * bitsPerWord) + size_t(__builtin_ctzll(bits)));
+      }
+    }
+  }
+
+private:
+  vector<Word> words;
+};
+
+#endif // LINESET_H
@@ -0,0 +1,321 @@
+#ifndef LINETABLE_H
+#define LINETABLE_H
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+
+#include <array>
+using std::array;
+
+#include <atomic>
+using std::atomic;
+
+#include <thread>
+using std::thread;
+
+#include <utility>
+
+#include <vector>
+using std::vector;
+
+#include "boardlocation.h"
+#include "boardset.h"
+#include "lineid.h"
+#include "line.h"
+#include "linedb.h"
+#include "lineset.h"
+
+// Directed tables hold a line for every ordered src..dst pair. Since
+// Bresenham isn't symmetric, src..dst and dst..src can differ by a
+// pixel or two, but both block on the same stones in Board::put, so
+// Undirected tables hold one line per unordered pair instead: the one
+// drawn from the endpoint with the smaller offset. lineIdOf() always
+// returns that endpoint as src, and indexOf() accepts either order.
+// That halves the table and the work put() does per stone.
+
+enum LineMode {
+  Directed,
+  Undirected,
+
+  EoLineMode
+};
+
+// The most lines of a LineTable through any one point, for sizing the
+// counts Board keeps of them. A Bresenham line depends only on the
+// offset from src to dst, so each offset's pixels are drawn once, and
+// each adds one line to every point in the rectangle that pixel covers
+// as src moves over the board: a rectangle added to a difference array,
+// summed once at the end. That is cheap enough for the compiler even
+// on 19x19, where drawing every line isn't.
+
+template<size_t NRows, size_t NCols, LineMode Mode> struct LinesThrough {
+  typedef Line<NRows, NCols> LineRC;
+
+  static constexpr size_t max() {
+    array<long, (NRows + 1) * (NCols + 1)> added = {};
+    int const nRows = int(NRows);
+    int const nCols = int(NCols);
+
+    for (int dr = 1 - nRows; dr < nRows; dr += 1) {
+      for (int dc = 1 - nCols; dc < nCols; dc += 1) {
+	if ((Mode == Directed && (dr != 0 || dc != 0)) || (Mode == Undirected && 0 < (dr * nCols) + dc)) {
+	  int r0 = dr < 0 ? -dr : 0;
+	  int r1 = dr < 0 ? nRows - 1 : nRows - 1 - dr;
+	  int c0 = dc < 0 ? -dc : 0;
+	  int c1 = dc < 0 ? nCols - 1 : nCols - 1 - dc;
+
+	  LineRC::bresenham(0, 0, dr, dc,
+			    [&](int r, int c) {
+			      added[((r0 + r) * (nCols + 1)) + c0 + c] += 1;
+			      added[((r0 + r) * (nCols + 1)) + c1 + c + 1] -= 1;
+			      added[((r1 + r + 1) * (nCols + 1)) + c0 + c] -= 1;
+			      added[((r1 + r + 1) * (nCols + 1)) + c1 + c + 1] += 1;
+			    });
+	}
+      }
+    }
+
+    long most = 0;
+    for (int r = 0; r < nRows; r += 1) {
+      for (int c = 0; c < nCols; c += 1) {
+	long &n = added[(r * (nCols + 1)) + c];
+	n += (0 < r ? added[((r - 1) * (nCols + 1)) + c] : 0) + (0 < c ? added[(r * (nCols + 1)) + c - 1] : 0) -
+	     (0 < r && 0 < c ? added[((r - 1) * (nCols + 1)) + c - 1] : 0);
+	most = most < n ? n : most;
+      }
+    }
+    return size_t(most);
+  }
+};
+
+// What every line table shares, for a Derived table with lineIdOf()
+// and operator[]: printing its lines, and, unless Derived has its own,
+// no precomputed membership() (see LineTable).
+
+template<typename Derived> class LineTableBase {
+public:
+  LineSet::Word const *membership(size_t) const {
+    return 0;
+  }
+
+  // A line as src..dst:{pixels}, and just its pixels.
+
+  void fprint(FILE *out, size_t index) const {
+    Derived::lineIdOf(typename Derived::LineIndex(index)).fprint(out);
+    fprintf(out, ":");
+    fprintPixels(out, index);
+  }
+  void fprintPixels(FILE *out, size_t index) const {
+    fprintf(out, "{");
+    char const *comma = "";
+    for (auto const &l : static_cast<Derived const &>(*this)[typename Derived::LineIndex(index)]) {
+      fprintf(out, "%s", comma);
+      l.fprint(out);
+      comma = ",";
+    }
+    fprintf(out, "}");
+  }
+};
+
+// Every src..dst line on an NRows x NCols board, packed into one
+// offsets array and one pixel array (compressed sparse rows), and
+// indexed by a dense LineIndex. The table is immutable, so it is built
+// once per board size, by instance(), and shared by every Board.
+//
+// Line indices are ordered by src, then dst, skipping src == dst (and,
+// if Undirected, dst < src), so indexOf() and lineIdOf() are plain
+// arithmetic.
+//
+// Building the table is spread over every core (so link with -pthread):
+// the offsets and pixels are sized up front, and each thread then
+// fills in the lines out of one src at a time, which no other thread
+// touches. The result is the same whatever the number of threads.
+//
+// If mklinedb has saved this table (see linedb.h), instance() maps the
+// saved copy instead of building one, and membership() then also has
+// the lines through each intersection ready to copy.
+
+template<size_t NRows, size_t NCols, LineMode Mode = Directed> class LineTable : public LineTableBase<LineTable<NRows, NCols, Mode>> {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef PackedLine<NRows, NCols> PackedLineRC;
+  typedef typename PackedLineRC::Pixel Pixel;
+  typedef uint32_t LineIndex;
+
+  // The pixels of one line, src to dst inclusive, packed (see line.h)
+  // but read back as BoardLocations.
+
+  typedef PackedPixels<NRows, NCols> Pixels;
+
+  static constexpr size_t nPoints = NRows * NCols;
+  static constexpr size_t nLines = Mode == Directed ? nPoints * (nPoints - 1) : (nPoints * (nPoints - 1)) / 2;
+  static constexpr size_t maxLinesThrough = LinesThrough<NRows, NCols, Mode>::max();
+
+  static LineTable const &instance() {
+    static LineTable const table;
+    return table;
+  }
+
+  static LineIndex indexOf(LineIdRC const &lineId) {
+    size_t src = lineId.src;
+    size_t dst = lineId.dst;
+
+    assert(src != dst);
+    if (Mode == Directed) {
+      return LineIndex((src * (nPoints - 1)) + (dst < src ? dst : dst - 1));
+    }
+    if (dst < src) {
+      std::swap(src, dst);
+    }
+    return LineIndex(firstFrom(src) + (dst - src - 1));
+  }
+  static LineIdRC lineIdOf(LineIndex index) {
+    if (Mode == Directed) {
+      size_t src = index / (nPoints - 1);
+      size_t dst = index % (nPoints - 1);
+
+      return LineIdRC(LocationRC(src), LocationRC(dst < src ? dst : dst + 1));
+    }
+
+    // Invert firstFrom(), a quadratic in src, then correct for any
+    // rounding in the square root.
+
+    double b = double((2 * nPoints) - 1);
+    size_t src = size_t((b - std::sqrt((b * b) - (8.0 * double(index)))) / 2.0);
+    while (0 < src && index < firstFrom(src)) {
+      src -= 1;
+    }
+    while (firstFrom(src + 1) <= index) {
+      src += 1;
+    }
+    return LineIdRC(LocationRC(src), LocationRC(src + 1 + (index - firstFrom(src))));
+  }
+
+  size_t size() const { return nLines; }
+  Pixels operator[](LineIndex index) const {
+    Pixels line = { pixelsAt + offsetsAt[index], pixelsAt + offsetsAt[index + 1] };
+    return line;
+  }
+
+  // The raw arrays, for saving the table.
+
+  uint32_t const *offsetData() const { return offsetsAt; }
+  Pixel const *pixelData() const { return pixelsAt; }
+  size_t nPixels() const { return offsetsAt[nLines]; }
+
+  // The LineSet words of the lines through l, if the table was mapped
+  // from a line database, or 0 if they have to be gathered.
+
+  LineSet::Word const *membership(size_t l) const {
+    return membershipAt ? membershipAt + (l * LineSet::wordsFor(nLines)) : 0;
+  }
+
+private:
+  // The index of the first Undirected line out of src, src..src + 1.
+
+  static size_t firstFrom(size_t src) {
+    return (src * ((2 * nPoints) - src - 1)) / 2;
+  }
+
+  // The index of the first line out of src, in either mode; the lines
+  // out of src end where those out of src + 1 begin.
+
+  static size_t firstLine(size_t src) {
+    return Mode == Directed ? src * (nPoints - 1) : firstFrom(src);
+  }
+
+  // Call work(src) once for every src, from a thread per core. Each
+  // thread takes the next src as it finishes the last, since sources
+  // have different numbers of lines in an Undirected table.
+
+  template<typename Work> static void forEachSource(Work const &work) {
+    size_t nThreads = std::min(size_t(std::max(thread::hardware_concurrency(), 1u)), nPoints);
+    atomic<size_t> next(0);
+
+    auto worker = [&]() {
+      for (size_t src = next++; src < nPoints; src = next++) {
+	work(src);
+      }
+    };
+
+    vector<thread> threads;
+    for (size_t t = 1; t < nThreads; t += 1) {
+      threads.push_back(thread(worker));
+    }
+    worker();
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  LineTable() :
+    offsets (),
+    pixels (),
+    offsetsAt (0),
+    pixelsAt (0),
+    membershipAt (0)
+  {
+    size_t const nWords = LineSet::wordsFor(nLines);
+    LineDb const *db =
+      LineDb::find(NRows, NCols, Mode, sizeof(Pixel), sizeof(BoardSet<NRows, NCols>), nLines);
+
+    if (db &&
+	db->sectionSize(LineDbOffsets) == (nLines + 1) * sizeof(uint32_t) &&
+	db->sectionSize(LineDbMembership) == nPoints * nWords * sizeof(LineSet::Word)
+       ) {
+      offsetsAt = static_cast<uint32_t const *>(db->section(LineDbOffsets));
+      pixelsAt = static_cast<Pixel const *>(db->section(LineDbPixels));
+      membershipAt = static_cast<LineSet::Word const *>(db->section(LineDbMembership));
+
+      if (db->sectionSize(LineDbPixels) == nPixels() * sizeof(Pixel)) {
+	return;
+      }
+    }
+
+    // Size every line first, so the pixels land in one allocation...
+
+    offsets.resize(nLines + 1);
+    offsets[0] = 0;
+    forEachSource([&](size_t src) {
+      for (size_t id = firstLine(src); id < firstLine(src + 1); id += 1) {
+	offsets[id + 1] = uint32_t(LineRC::length(lineIdOf(LineIndex(id))));
+      }
+    });
+    for (LineIndex id = 0; id < nLines; id += 1) {
+      offsets[id + 1] += offsets[id];
+    }
+    pixels.resize(offsets[nLines]);
+
+    // ... then rasterize each one into its own slice.
+
+    forEachSource([&](size_t src) {
+      for (size_t id = firstLine(src); id < firstLine(src + 1); id += 1) {
+	size_t n = PackedLineRC::draw(lineIdOf(LineIndex(id)), &pixels[offsets[id]]);
+	assert(offsets[id] + n == offsets[id + 1]);
+      }
+    });
+
+    offsetsAt = &offsets[0];
+    pixelsAt = &pixels[0];
+    membershipAt = 0;
+  }
+  LineTable(LineTable const &);
+
+  // The table is in offsets and pixels when built here, or in a mapped
+  // line database; either way offsetsAt and pixelsAt point at it.
+
+  vector<uint32_t> offsets;
+  vector<Pixel> pixels;
+
+  uint32_t const *offsetsAt;
+  Pixel const *pixelsAt;
+  LineSet::Word const *membershipAt;
+};
+
+#endif // LINETABLE_H
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "betweenmasks.h"
+#include "boardset.h"
+#include "linedb.h"
+#include "lineset.h"
+#include "linetable.h"
+
+// Writes the line database (see linedb.h) for one board size and
+// LineMode, into $LINEDB or the current directory:
+//
+//	mklinedb 19		linedb-19x19.bin
+//	mklinedb 19 u		linedb-19x19u.bin
+//
+// Run it once per machine, or whenever line.h or linedb.h change.
+
+template<size_t NRows, size_t NCols, LineMode Mode> bool mklinedb()
+{
+  typedef LineTable<NRows, NCols, Mode> LineTableRC;
+  typedef typename LineTableRC::LineIndex LineIndex;
+  typedef BetweenMasks<NRows, NCols> BetweenMasksRC;
+  typedef BoardSet<NRows, NCols> BoardSetRC;
+
+  // Build the tables afresh, rather than from the database being
+  // replaced, which may be stale, or this very file.
+
+  LineDb::bypassed() = true;
+
+  LineTableRC const &lines = LineTableRC::instance();
+
+  // The lines through each intersection, row by row.
+
+  size_t const nWords = LineSet::wordsFor(LineTableRC::nLines);
+  vector<LineSet::Word> membership(LineTableRC::nPoints * nWords);
+  {
+    vector<LineSet> sets(LineTableRC::nPoints, LineSet(LineTableRC::nLines));
+    for (LineIndex id = 0; id < lines.size(); id += 1) {
+      for (auto const &l : lines[id]) {
+	sets[l].set(id);
+      }
+    }
+    for (size_t l = 0; l < LineTableRC::nPoints; l += 1) {
+      memcpy(&membership[l * nWords], sets[l].data(), nWords * sizeof(LineSet::Word));
+    }
+  }
+
+  // BetweenMasks only index Directed tables.
+
+  vector<BoardSetRC> masks;
+  if (Mode == Directed) {
+    BetweenMasksRC const &between = BetweenMasksRC::instance();
+    masks.reserve(LineTableRC::nLines);
+    for (LineIndex id = 0; id < lines.size(); id += 1) {
+      masks.push_back(between[id]);
+    }
+  }
+
+  LineDbHeader header;
+  memset(&header, 0, sizeof(header));
+  header.nRows = NRows;
+  header.nCols = NCols;
+  header.mode = Mode;
+  header.pixelSize = sizeof(typename LineTableRC::Pixel);
+  header.maskSize = sizeof(BoardSetRC);
+  header.nLines = LineTableRC::nLines;
+
+  void const *data[EoLineDbSection] = {
+    lines.offsetData(),
+    lines.pixelData(),
+    membership.data(),
+    masks.data()
+  };
+  size_t const size[EoLineDbSection] = {
+    (LineTableRC::nLines + 1) * sizeof(uint32_t),
+    lines.nPixels() * sizeof(typename LineTableRC::Pixel),
+    membership.size() * sizeof(LineSet::Word),
+    masks.size() * sizeof(BoardSetRC)
+  };
+
+  string path = LineDb::pathFor(NRows, NCols, Mode);
+  if (!LineDb::write(path.c_str(), header, data, size)) {
+    fprintf(stderr, "mklinedb: can't write %s\n", path.c_str());
+    return false;
+  }
+  fprintf(stdout, "%s: %zu lines, %zu pixels\n", path.c_str(), size_t(LineTableRC::nLines), lines.nPixels());
+  return true;
+}
+
+template<size_t N> bool mklinedb(bool undirected)
+{
+  return undirected ? mklinedb<N, N, Undirected>() : mklinedb<N, N, Directed>();
+}
+
+int main(int argc, char const *argv[])
+{
+  size_t n = argc > 1 ? strtoul(argv[1], 0, 10) : 0;
+  bool undirected = argc > 2 && argv[2][0] == 'u';
+
+  switch (n) {
+  case 9: return mklinedb<9>(undirected) ? 0 : 1;
+  case 13: return mklinedb<13>(undirected) ? 0 : 1;
+  case 19: return mklinedb<19>(undirected) ? 0 : 1;
+  }
+
+  fprintf(stderr, "usage: mklinedb 9|13|19 [u]\n");
+  return 2;
+}
@@ -0,0 +1,409 @@
+#ifndef PADDEDBOARDSET_H
+#define PADDEDBOARDSET_H
+
+#include <cassert>
+#include <cstdint>
+
+#include <array>
+using std::array;
+
+#include "boardsetsimd.h"
+
+// A set of points on an NRows x NCols board, one bit each, laid out
+// as in g.cpp's BoardSet: row by row, with a row of padding above and
+// below the board and a column of padding between rows (so each row is
+// NCols + 1 bits), plus one more bit in front, so that every point one
+// step off the board, corners included, is a padding bit:
+//
+//	toIndex(r, c) = ((r + 1) * (NCols + 1)) + (c + 1)
+//
+// Stepping to a neighbour is then the same whole-board shift for every
+// point, and the padding catches whatever steps off the board, so the
+// neighbours of a whole set cost a few word operations: shifted(d),
+// dilate(), erode() and neighbours(). The bits are in an explicit array
+// of 64-bit words, rounded up to a multiple of four, and the word-wise
+// operations go through the SIMD kernels in boardsetsimd.h.
+//
+// Padding bits are never set by the set operations; set() and ~ work
+// over the board's points only.
+//
+// Directions are the usual Direction, N through NW (see location.h).
+
+template<size_t NRows, size_t NCols> class PaddedBoardSet {
+public:
+  typedef uint64_t Word;
+
+  static size_t const bitsPerWord = 64;
+  static size_t const stride = NCols + 1;
+  static size_t const nBits = ((NRows + 2) * stride) + 1;
+  static size_t const nWords = (((nBits + bitsPerWord - 1) / bitsPerWord) + 3) & ~size_t(3);
+
+  // A single bit, for writing through operator()(row, col).
+
+  class Reference {
+  public:
+    Reference(Word &_word, Word _mask) : word (_word), mask (_mask) { }
+    operator bool() const { return (word & mask) != 0; }
+    Reference &operator=(bool b) {
+      word = b ? word | mask : word & ~mask;
+      return *this;
+    }
+    Reference &operator=(Reference const &that) {
+      return *this = bool(that);
+    }
+
+  private:
+    Word &word;
+    Word mask;
+  };
+
+  PaddedBoardSet() {
+    words.fill(0);
+  }
+
+  static size_t toIndex(int row, int col) {
+    assert(-1 <= row && row <= int(NRows) && -1 <= col && col <= int(NCols));
+    return (size_t(row + 1) * stride) + size_t(col + 1);
+  }
+
+  // Every point on the board, and every padding bit.
+
+  static PaddedBoardSet const &onBoard() {
+    static PaddedBoardSet const points = board();
+    return points;
+  }
+  static PaddedBoardSet const &padding() {
+    static PaddedBoardSet const bits = onBoard().flipped();
+    return bits;
+  }
+
+  bool operator()(int row, int col) const {
+    return test(toIndex(row, col));
+  }
+  Reference operator()(int row, int col) {
+    size_t i = toIndex(row, col);
+    return Reference(words[i / bitsPerWord], Word(1) << (i % bitsPerWord));
+  }
+
+  bool test(size_t i) const {
+    return (words[i / bitsPerWord] >> (i % bitsPerWord)) & 1;
+  }
+
+  void set() {
+    *this = onBoard();
+  }
+  void reset() {
+    words.fill(0);
+  }
+
+  size_t count() const {
+    return BoardSetSimd::count<nWords>(words.data());
+  }
+  bool none() const {
+    return !any();
+  }
+  bool any() const {
+    return BoardSetSimd::any<nWords>(words.data());
+  }
+
+  PaddedBoardSet &operator&=(PaddedBoardSet const &that) {
+    BoardSetSimd::apply<nWords, SimdAnd>(words.data(), that.words.data());
+    return *this;
+  }
+  PaddedBoardSet &operator|=(PaddedBoardSet const &that) {
+    BoardSetSimd::apply<nWords, SimdOr>(words.data(), that.words.data());
+    return *this;
+  }
+  PaddedBoardSet &operator^=(PaddedBoardSet const &that) {
+    BoardSetSimd::apply<nWords, SimdXor>(words.data(), that.words.data());
+    return *this;
+  }
+
+  // *this &= ~that.
+
+  PaddedBoardSet &andNot(PaddedBoardSet const &that) {
+    BoardSetSimd::apply<nWords, SimdAndNot>(words.data(), that.words.data());
+    return *this;
+  }
+  PaddedBoardSet operator&(PaddedBoardSet const &that) const { return PaddedBoardSet(*this) &= that; }
+  PaddedBoardSet operator|(PaddedBoardSet const &that) const { return PaddedBoardSet(*this) |= that; }
+  PaddedBoardSet operator^(PaddedBoardSet const &that) const { return PaddedBoardSet(*this) ^= that; }
+
+  // The points of the board not in the set.
+
+  PaddedBoardSet operator~() const {
+    return *this ^ onBoard();
+  }
+
+  bool operator==(PaddedBoardSet const &that) const { return words == that.words; }
+  bool operator!=(PaddedBoardSet const &that) const { return words != that.words; }
+
+  // Every point moved one step towards d; what steps off the board is
+  // dropped.
+
+  PaddedBoardSet shifted(size_t d) const {
+    return shiftedBy(offsetToThe(d)) & onBoard();
+  }
+
+  // The set with its four (N, E, S and W) neighbours; and the points
+  // whose four neighbours are all in the set, counting the points off
+  // the board as in it, so erode() is dilate() of the complement,
+  // complemented.
+
+  PaddedBoardSet dilate() const {
+    return (spread() &= onBoard()) |= *this;
+  }
+  PaddedBoardSet erode() const {
+    return ~(~*this).dilate();
+  }
+
+  // The part of mask connected, through mask, to the set: the set
+  // dilated within mask until it stops growing.
+
+  PaddedBoardSet grownWithin(PaddedBoardSet const &mask) const {
+    PaddedBoardSet const within = mask & onBoard();
+    PaddedBoardSet grown = *this & within;
+
+    size_t lo = nWords;
+    size_t hi = 0;
+    for (size_t w = 0; w < nWords; w += 1) {
+      if (grown.words[w]) {
+	lo = lo < w ? lo : w;
+	hi = w;
+      }
+    }
+    if (lo <= hi) {
+      within.grow(grown, lo, hi);
+    }
+    return grown;
+  }
+
+  // Call f(part, next) for each connected part of the set (its points
+  // joined N, E, S or W), in the order of their first points, with next
+  // the points of around beside the part. Each part is grown from its
+  // first point, taken out of what's left and given its neighbours over
+  // just the words it covers, and the search for the next first point
+  // picks up where the last left off.
+
+  template<typename F> void forEachPart(PaddedBoardSet const &around, F f) const {
+    PaddedBoardSet const aroundOn = around & onBoard();
+    PaddedBoardSet rest = *this & onBoard();
+    for (size_t w = 0; w < nWords; ) {
+      if (!rest.words[w]) {
+	w += 1;
+	continue;
+      }
+
+      PaddedBoardSet part;
+      part.words[w] = rest.words[w] & -rest.words[w];
+      size_t lo = w;
+      size_t hi = w;
+      rest.grow(part, lo, hi);
+      for (size_t v = lo; v <= hi; v += 1) {
+	rest.words[v] &= ~part.words[v];
+      }
+
+      PaddedBoardSet next;
+      if (bitsPerWord <= stride) {
+	next = part.neighbours() & aroundOn;
+      } else {
+	size_t from = 0 < lo ? lo - 1 : 0;
+	size_t to = hi + 1 < nWords ? hi + 1 : nWords - 1;
+	for (size_t v = from; v <= to; v += 1) {
+	  next.words[v] = part.spreadWord(v) & ~part.words[v] & aroundOn.words[v];
+	}
+      }
+      f(part, next);
+    }
+  }
+
+  // The points next to the set, but not in it.
+
+  PaddedBoardSet neighbours() const {
+    return dilate() ^ *this;
+  }
+
+  // The set's first point, row by row, alone; or nothing.
+
+  PaddedBoardSet lowest() const {
+    PaddedBoardSet result;
+    for (size_t w = 0; w < nWords; w += 1) {
+      if (words[w]) {
+	result.words[w] = words[w] & -words[w];
+	break;
+      }
+    }
+    return result;
+  }
+
+  // Call f(row, col) for every point in the set, row by row.
+
+  template<typename F> void forEach(F f) const {
+    for (size_t w = 0; w < nWords; w += 1) {
+      for (Word bits = words[w]; bits; bits &= bits - 1) {
+	size_t i = (w * bitsPerWord) + size_t(__builtin_ctzll(bits)) - 1;
+	f(i / stride - 1, i % stride);
+      }
+    }
+  }
+
+  static int offsetToThe(size_t d) {
+    static int const offsets[8] = {
+      -int(stride),		// N
+      -int(stride) + 1,		// NE
+      +1,			// E
+      +int(stride) + 1,		// SE
+      +int(stride),		// S
+      +int(stride) - 1,		// SW
+      -1,			// W
+      -int(stride) - 1		// NW
+    };
+    return offsets[d];
+  }
+
+private:
+  static PaddedBoardSet board() {
+    PaddedBoardSet points;
+    for (size_t r = 0; r < NRows; r += 1) {
+      for (size_t c = 0; c < NCols; c += 1) {
+	points(r, c) = true;
+      }
+    }
+    return points;
+  }
+
+  // Every bit, padding included, flipped.
+
+  PaddedBoardSet flipped() const {
+    PaddedBoardSet result;
+    for (size_t w = 0; w < nWords; w += 1) {
+      result.words[w] = ~words[w];
+    }
+    result.clearPastEnd();
+    return result;
+  }
+
+  // Clear the bits past nBits, in the last word used and any rounding
+  // words after it.
+
+  void clearPastEnd() {
+    size_t last = (nBits - 1) / bitsPerWord;
+    if (nBits % bitsPerWord) {
+      words[last] &= (Word(1) << (nBits % bitsPerWord)) - 1;
+    }
+    for (size_t w = last + 1; w < nWords; w += 1) {
+      words[w] = 0;
+    }
+  }
+
+  // Grow part, in place, within this set (which has no padding) until
+  // it stops growing. part's points are all in words lo..hi, and on
+  // return lo..hi covers the grown part.
+  //
+  // Growth goes a word at a time, sweeping up the words: a word can
+  // only grow if it or a word either side changed in the last sweep,
+  // so each sweep covers just those, and a small group costs a few
+  // words rather than the board. (On boards over 62 columns, where a
+  // neighbour can be a word or more away, it grows by spread().)
+
+  void grow(PaddedBoardSet &part, size_t &lo, size_t &hi) const {
+    if (bitsPerWord <= stride) {
+      for (PaddedBoardSet next = part.spread() & *this; next != part; next = part.spread() & *this) {
+	part = next;
+      }
+      lo = 0;
+      hi = nWords - 1;
+      return;
+    }
+
+    size_t changedLo = lo;
+    size_t changedHi = hi;
+    while (changedLo <= changedHi) {
+      size_t from = 0 < changedLo ? changedLo - 1 : 0;
+      size_t to = changedHi + 1 < nWords ? changedHi + 1 : nWords - 1;
+      changedLo = nWords;
+      changedHi = 0;
+      for (size_t w = from; w <= to; w += 1) {
+	Word x = part.words[w];
+	Word y = part.spreadWord(w) & words[w];
+	if (y != x) {
+	  part.words[w] = y;
+	  changedLo = changedLo < w ? changedLo : w;
+	  changedHi = w;
+	}
+      }
+      lo = changedLo < lo ? changedLo : lo;
+      hi = changedLo <= changedHi && hi < changedHi ? changedHi : hi;
+    }
+  }
+
+  // The set and its four neighbours, padding and all. On boards up to
+  // 62 columns every neighbour is less than a word away, so each word
+  // is built from itself and the words either side, with no shifted
+  // copies of the whole set.
+
+  PaddedBoardSet spread() const {
+    if (bitsPerWord <= stride) {
+      return *this | shiftedBy(-int(stride)) | shiftedBy(+int(stride)) | shiftedBy(+1) | shiftedBy(-1);
+    }
+
+    PaddedBoardSet result;
+    for (size_t w = 0; w < nWords; w += 1) {
+      result.words[w] = spreadWord(w);
+    }
+    result.clearPastEnd();
+    return result;
+  }
+
+  // Word w of spread(), from words w - 1, w and w + 1, on boards up to
+  // 62 columns.
+
+  Word spreadWord(size_t w) const {
+    unsigned const s = unsigned(stride % bitsPerWord);
+    unsigned const t = unsigned((bitsPerWord - s) % bitsPerWord);
+    Word x = words[w];
+    Word below = 0 < w ? words[w - 1] : 0;
+    Word above = w + 1 < nWords ? words[w + 1] : 0;
+    return x | (x << 1) | (x >> 1) | (x << s) | (x >> s)
+	     | (below >> (bitsPerWord - 1)) | (below >> t) | (above << (bitsPerWord - 1)) | (above << t);
+  }
+
+  // Every bit moved up by n places (down, if n is negative); bits moved
+  // past either end are lost.
+
+  PaddedBoardSet shiftedBy(int n) const {
+    PaddedBoardSet result;
+    size_t m = size_t(n < 0 ? -n : n);
+    size_t by = m / bitsPerWord;
+    size_t bits = m % bitsPerWord;
+
+    // Neighbours, on boards up to 62 columns, are less than a word
+    // away.
+
+    if (by == 0 && bits != 0) {
+      if (0 < n) {
+	BoardSetSimd::shiftUp<nWords>(result.words.data(), words.data(), unsigned(bits));
+      } else {
+	BoardSetSimd::shiftDown<nWords>(result.words.data(), words.data(), unsigned(bits));
+      }
+      result.clearPastEnd();
+      return result;
+    }
+
+    for (size_t w = 0; w < nWords; w += 1) {
+      if (0 <= n && by <= w) {
+	Word carry = bits && by < w ? words[w - by - 1] >> (bitsPerWord - bits) : 0;
+	result.words[w] = (words[w - by] << bits) | carry;
+      } else if (n < 0 && w + by < nWords) {
+	Word carry = bits && w + by + 1 < nWords ? words[w + by + 1] << (bitsPerWord - bits) : 0;
+	result.words[w] = (words[w + by] >> bits) | carry;
+      }
+    }
+    result.clearPastEnd();
+    return result;
+  }
+
+  alignas(64) array<Word, nWords> words;
+};
+
+#endif // PADDEDBOARDSET_H
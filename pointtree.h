@@ -0,0 +1,290 @@
+#ifndef POINTTREE_H
+#define POINTTREE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+
+#include <vector>
+using std::vector;
+
+#include "boardlocation.h"
+#include "boardset.h"
+
+struct Point {
+  Point(int _x, int _y) :
+    x (_x),
+    y (_y)
+  {
+  }
+  bool operator==(Point const &that) const {
+    return x == that.x && y == that.y;
+  }
+  bool operator<(Point const &that) const {
+    return x < that.x || (x == that.x && y < that.y);
+  }
+
+  int x;
+  int y;
+  void fprint(FILE *out) const {
+    fprintf(out, "{%+3d,%+3d}", x, y);
+  }
+};
+
+// A prefix trie of rays: each path from the root is the prefix of one
+// or more rays from the origin, and endsHere marks the nodes where a ray
+// ends.
+
+struct PointTree: public Point {
+  PointTree(Point const &that) :
+    Point (that),
+    parent (0),
+    endsHere (false)
+  {
+  }
+  ~PointTree() {
+    for (auto c = children.begin(); c != children.end(); c++) {
+      delete *c;
+    }
+  }
+
+  PointTree *hasChild(Point const &point) {
+    for (auto c = children.begin(); c != children.end(); c++) {
+      if (**c == point) {
+	return *c;
+      }
+    }
+    return 0;
+  }
+
+  void addChild(PointTree *c) {
+    children.push_back(c);
+    c->parent = this;
+  }
+
+  // Merge line, a ray from this node's point, into the trie.
+
+  void addRay(vector<Point> const &line) {
+    PointTree *pt = this;
+
+    for (size_t p = 1; p < line.size(); p += 1) {
+      Point const &point = line[p];
+
+      if (PointTree *ct = pt->hasChild(point)) {
+	pt = ct;
+	continue;
+      }
+
+      PointTree *ct = new PointTree(point);
+      pt->addChild(ct);
+      pt = ct;
+    }
+    pt->endsHere = true;
+  }
+
+  size_t size() const {
+    size_t n = 1;
+
+    for (auto c = children.cbegin(); c != children.cend(); c++) {
+      n += (*c)->size();
+    }
+    return n;
+  }
+
+  size_t numberOfForks() const {
+    size_t nForks = 1 < children.size() ? children.size() - 1 : 0;
+
+    for (auto c = children.cbegin(); c != children.cend(); c++) {
+      nForks += (*c)->numberOfForks();
+    }
+
+    return nForks;
+  }
+
+  void fprint(FILE *out, size_t depth = 0) const {
+    for (size_t d = 0; d < depth; d += 1) {
+      fprintf(out, ".   ");
+    }
+    Point::fprint(out);
+    fprintf(out, "\n");
+    for (auto c = children.cbegin(); c != children.cend(); c++) {
+      (*c)->fprint(out, depth + 1);
+    }
+  }
+
+  // void fprintNested(FILE *out, size_t length = 0) const {
+  //   Point::fprint(out);
+  // 
+  //   if (children.size()) {
+  //     fprintf(stdout, ",");
+  // 
+  //     if (size_t nForks = numberOfForks()) {
+  //     	fprintf(stdout, "{");
+  //     
+  //     	auto c = children.cbegin();
+  //     	(*c)->fprintNested(out, 0);
+  //     
+  //     	for (; c != children.cend(); c++) {
+  //     	  fprintf(stdout, ",");
+  //     	  (*c)->fprintNested(out, 0);
+  //     	}
+  //     	fprintf(stdout, "}\n");
+  //     } else if (!children.empty()) {
+  //     	assert(children.size() == 1);
+  //     
+  //     	children[0]->fprintNested(out, length + 1);
+  //     }
+  //   } else {
+  //     fprintf(stdout, "\n");
+  //   }
+  // }
+
+  size_t fprintNested(FILE *out, size_t nFwForks = 0) const {
+    size_t nBkForks = 0;
+    switch (children.size()) {
+    case 0:
+      Point::fprint(out);
+      return 0;
+    case 1:
+      nBkForks = children[0]->fprintNested(out, nFwForks);
+      fprintf(stdout, ",");
+      Point::fprint(out);
+      return 0;
+    default:
+      fprintf(stdout, "{");
+      auto c = children.cbegin();
+      nBkForks = (*c)->fprintNested(out, nFwForks + 1);
+      for (; c != children.end(); c++) {
+	fprintf(stdout, ",\n");
+	nBkForks += (*c)->fprintNested(out, nFwForks + 1);
+      }
+      Point::fprint(out);
+      fprintf(stdout, "}\n");
+      return children.size() - 1;
+    }
+  }
+
+  PointTree *parent;
+  vector<PointTree *> children;
+  bool endsHere;
+};
+
+inline void drawLineTo(vector<Point> &line, int x1, int y1)
+{
+  // fprintf(stdout, "drawLineTo({0,0}..{%+3d,%+3d}): ", x1, y1);
+
+  int x0 = 0;
+  int y0 = 0;
+
+  int dx = abs(x1 - x0);
+  int sx = x0 < x1 ? +1 : -1;
+  int dy = abs(y1 - y0);
+  int sy = y0 < y1 ? +1 : -1;
+  int err = dx - dy;
+
+  for (line.push_back(Point(x0, y0)); !(x0 == x1 && y0 == y1); line.push_back(Point(x0, y0))) {
+    int e2 = 2 * err;
+    if (e2 > -dy) {
+      err -= dy;
+      x0 += sx;
+    }
+    if (e2 < dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+// A visibility engine over a PointTree of the Bresenham rays from the
+// origin to every offset a board can hold, flattened into pre-order so
+// a query is one forward pass over an array. From any src, a node is
+// the point src + (x, y); a ray ending there means src sees it, unless
+// a stone lies strictly between. Rays are monotone in both coordinates,
+// so once a node is off the board or on a stone its whole subtree can
+// be skipped. Shared prefixes mean each point is visited about once per
+// query, however many rays pass through it.
+//
+// The rays are the lines of LineTable, translated to the origin, so the
+// answers agree with Board and with BetweenMasks.
+
+template<size_t NRows, size_t NCols> class RayTrie {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef BoardSet<NRows, NCols> BoardSetRC;
+
+  struct Node {
+    int16_t x;
+    int16_t y;
+    bool endsHere;
+    uint32_t skip;		// The index just past this node's subtree.
+  };
+
+  static RayTrie const &instance() {
+    static RayTrie const trie;
+    return trie;
+  }
+
+  size_t size() const { return nodes.size(); }
+
+  // Every intersection, other than src itself, that src can see past
+  // stones, in a single depth-first pass.
+
+  BoardSetRC visibleFrom(LocationRC src, BoardSetRC const &stones) const {
+    BoardSetRC visible;
+    int r = int(src.row());
+    int c = int(src.col());
+
+    size_t i = 1;
+    while (i < nodes.size()) {
+      Node const &node = nodes[i];
+      int x = r + node.x;
+      int y = c + node.y;
+
+      if (x < 0 || int(NRows) <= x || y < 0 || int(NCols) <= y) {
+	i = node.skip;
+	continue;
+      }
+
+      size_t l = LocationRC::rcToOffset(x, y);
+      if (node.endsHere) {
+	visible[l] = 1;
+      }
+      i = stones[l] ? node.skip : i + 1;
+    }
+    return visible;
+  }
+
+private:
+  RayTrie() {
+    PointTree root(Point(0, 0));
+
+    for (int x = 1 - int(NRows); x < int(NRows); x += 1) {
+      for (int y = 1 - int(NCols); y < int(NCols); y += 1) {
+	if (x != 0 || y != 0) {
+	  vector<Point> line;
+	  drawLineTo(line, x, y);
+	  root.addRay(line);
+	}
+      }
+    }
+
+    nodes.reserve(root.size());
+    flatten(&root);
+  }
+  RayTrie(RayTrie const &);
+
+  void flatten(PointTree const *pt) {
+    size_t i = nodes.size();
+    Node node = { int16_t(pt->x), int16_t(pt->y), pt->endsHere, 0 };
+
+    nodes.push_back(node);
+    for (auto c = pt->children.cbegin(); c != pt->children.cend(); c++) {
+      flatten(*c);
+    }
+    nodes[i].skip = uint32_t(nodes.size());
+  }
+
+  vector<Node> nodes;
+};
+
+#endif // POINTTREE_H
@@ -0,0 +1,217 @@
+#ifndef REFLECTEDLINETABLE_H
+#define REFLECTEDLINETABLE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+
+#include <set>
+using std::set;
+
+#include <vector>
+using std::vector;
+
+#include "boardlocation.h"
+#include "lineid.h"
+#include "line.h"
+#include "linetable.h"
+#include "lineset.h"
+
+// Which unfolded ends the reflected lines of a board go to, and how
+// many of those lines there are.
+
+template<size_t NRows, size_t NCols, size_t MaxBounces> struct ReflectedEnds {
+  typedef Line<NRows, NCols> LineRC;
+
+  // An unfolded end x1 on a side of n points, for a line from x0, as
+  // long as the line doesn't leave the board at once from an edge.
+
+  static constexpr bool isEnd(int x0, int x1, size_t n) {
+    return !((x0 == 0 && x1 < 0) || (x0 == int(n) - 1 && int(n) - 1 < x1));
+  }
+
+  // How far off the board an end can be, in either direction, and
+  // still be at most MaxBounces bounces away.
+
+  static constexpr int reach(size_t n) {
+    return int((MaxBounces + 1) * (n - 1));
+  }
+
+  static constexpr size_t nEnds(int x0, size_t n, size_t b) {
+    size_t count = 0;
+    for (int x1 = -reach(n); x1 <= reach(n); x1 += 1) {
+      if (isEnd(x0, x1, n) && LineRC::bounces(x0, x1, n) == b) {
+	count += 1;
+      }
+    }
+    return count;
+  }
+
+  static constexpr size_t count() {
+    size_t count = 0;
+    for (size_t r = 0; r < NRows; r += 1) {
+      for (size_t c = 0; c < NCols; c += 1) {
+	for (size_t bx = 0; bx <= MaxBounces; bx += 1) {
+	  for (size_t by = bx == 0 ? 1 : 0; bx + by <= MaxBounces; by += 1) {
+	    count += nEnds(int(r), NRows, bx) * nEnds(int(c), NCols, by);
+	  }
+	}
+      }
+    }
+    return count;
+  }
+};
+
+// Every straight line of LineTable<NRows, NCols>, with the same indices,
+// followed by every "bank shot": a line that bounces off the edges of
+// the board between 1 and MaxBounces times (see Line's reflecting
+// constructor). A Board built on this table blocks bank shots exactly
+// as it blocks straight lines, so the lines through an intersection
+// also count the ones it reaches off the edges.
+//
+// Reflected lines are ordered by src, then by their unfolded end, row
+// then column. More than one of them can join the same src and dst, so
+// indexOf() only finds straight lines; lineIdOf() and reflections()
+// work for every line.
+//
+// A line that leaves the board at once from an edge pixel is the mirror
+// image of one going the other way, so only the latter is kept. Nor is
+// one that reaches its end's point before its end (see passesEnd()),
+// so every line's dst is its last pixel, passed nowhere else, and a
+// stone there is at an end of it as far as Board is concerned. Nor,
+// last, is one that covers the same points as a line from the same src
+// already kept, so Board counts no path twice. nLines counts every
+// unfolded end, which bounds the lines kept, for sizing LineSets;
+// size() is the number kept.
+
+template<size_t NRows, size_t NCols, size_t MaxBounces = 1> class ReflectedLineTable :
+  public LineTableBase<ReflectedLineTable<NRows, NCols, MaxBounces>> {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef LineTable<NRows, NCols> StraightLineTableRC;
+  typedef ReflectedEnds<NRows, NCols, MaxBounces> ReflectedEndsRC;
+  typedef typename StraightLineTableRC::LineIndex LineIndex;
+
+  static_assert(1 < NRows && 1 < NCols, "ReflectedLineTable: a board needs two sides to bounce between");
+
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  // The pixels of one line, src first, each pixel once, packed as in
+  // LineTable.
+
+  typedef PackedPixels<NRows, NCols> Pixels;
+
+  static size_t const nPoints = NRows * NCols;
+  static size_t const nStraightLines = StraightLineTableRC::nLines;
+  static size_t const nLines = nStraightLines + ReflectedEndsRC::count();
+
+  // No cheap exact count here: every bank shot might cross one point.
+
+  static constexpr size_t maxLinesThrough = StraightLineTableRC::maxLinesThrough + ReflectedEndsRC::count();
+
+  static ReflectedLineTable const &instance() {
+    static ReflectedLineTable const table;
+    return table;
+  }
+
+  static LineIndex indexOf(LineIdRC const &lineId) {
+    return StraightLineTableRC::indexOf(lineId);
+  }
+  static LineIdRC lineIdOf(LineIndex index) {
+    return instance().lineIds[index];
+  }
+
+  size_t size() const { return lineIds.size(); }
+  size_t reflections(LineIndex index) const { return bounced[index]; }
+
+  Pixels operator[](LineIndex index) const {
+    Pixels line = { &pixels[0] + offsets[index], &pixels[0] + offsets[index + 1] };
+    return line;
+  }
+
+  void fprint(FILE *out, LineIndex index) const {
+    lineIds[index].fprint(out);
+    fprintf(out, ":%zu:", reflections(index));
+    this->fprintPixels(out, index);
+  }
+
+private:
+  ReflectedLineTable() :
+    offsets (),
+    pixels (),
+    lineIds (),
+    bounced ()
+  {
+    offsets.reserve(nLines + 1);
+    lineIds.reserve(nLines);
+    bounced.reserve(nLines);
+
+    for (LineIndex id = 0; id < nStraightLines; id += 1) {
+      offsets.push_back(uint32_t(pixels.size()));
+      lineIds.push_back(StraightLineTableRC::lineIdOf(id));
+      bounced.push_back(0);
+      LineRC::bresenham(lineIds.back().src.row(), lineIds.back().src.col(), lineIds.back().dst.row(), lineIds.back().dst.col(),
+			[&](int x, int y) { pixels.push_back(Pixel((x * NCols) + y)); });
+    }
+
+    for (size_t src = 0; src < nPoints; src += 1) {
+      int x0 = int(src / NCols);
+      int y0 = int(src % NCols);
+
+      // The points each line from src covers, straight ones included.
+
+      StraightLineTableRC const &straight = StraightLineTableRC::instance();
+      set<vector<Pixel>> covered;
+      for (LineIndex id = LineIndex(src * (nPoints - 1)); id < (src + 1) * (nPoints - 1); id += 1) {
+	covered.insert(coverOf(straight[id]));
+      }
+
+      for (int x1 = -ReflectedEndsRC::reach(NRows); x1 <= ReflectedEndsRC::reach(NRows); x1 += 1) {
+	for (int y1 = -ReflectedEndsRC::reach(NCols); y1 <= ReflectedEndsRC::reach(NCols); y1 += 1) {
+	  size_t b = LineRC::bounces(x0, x1, NRows) + LineRC::bounces(y0, y1, NCols);
+
+	  if (ReflectedEndsRC::isEnd(x0, x1, NRows) && ReflectedEndsRC::isEnd(y0, y1, NCols) && 0 < b && b <= MaxBounces &&
+	      !LineRC::passesEnd(x0, y0, x1, y1)
+	     ) {
+	    LineRC line(LocationRC(src), x1, y1);
+
+	    if (!covered.insert(coverOf(line)).second) {
+	      continue;
+	    }
+	    offsets.push_back(uint32_t(pixels.size()));
+	    for (auto const &l : line) {
+	      pixels.push_back(Pixel(size_t(l)));
+	    }
+	    lineIds.push_back(line.lineId);
+	    bounced.push_back(uint8_t(line.reflections));
+	  }
+	}
+      }
+    }
+    offsets.push_back(uint32_t(pixels.size()));
+    assert(lineIds.size() <= nLines);
+  }
+  ReflectedLineTable(ReflectedLineTable const &);
+
+  // The points a line covers, in order of offset.
+
+  template<typename Pixels> static vector<Pixel> coverOf(Pixels const &line) {
+    vector<Pixel> cover;
+    for (auto const &l : line) {
+      cover.push_back(Pixel(size_t(l)));
+    }
+    std::sort(cover.begin(), cover.end());
+    return cover;
+  }
+
+  vector<uint32_t> offsets;
+  vector<Pixel> pixels;
+  vector<LineIdRC> lineIds;
+  vector<uint8_t> bounced;
+};
+
+#endif // REFLECTEDLINETABLE_H
@@ -0,0 +1,237 @@
+#ifndef SGFREADER_H
+#define SGFREADER_H
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+// Just enough of SGF (see sgf.h) to load the positions of Go games: the
+// board size (SZ), the setup stones (AB and AW, compressed point lists
+// included) and the moves (B and W) of the main line of each game tree
+// in a collection. Every other property, and every variation past the
+// first, is skipped. Passes are dropped, and captures are not played
+// out, so a point can be listed again once its stone has been taken;
+// isMove tells the moves, which capture, from the setup stones, which
+// don't.
+//
+// Property identifiers are their capital letters: the lowercase ones
+// FF[3] allowed among them (GaMe for GM) are skipped, as FF[4] says.
+//
+// Points are SGF letters, a..z then A..Z, so a board is at most 52x52.
+
+struct SgfStone {
+  SgfStone(size_t _row, size_t _col, bool _isWhite, bool _isMove) :
+    row (_row),
+    col (_col),
+    isWhite (_isWhite),
+    isMove (_isMove)
+  {
+  }
+
+  size_t row;
+  size_t col;
+  bool isWhite;
+  bool isMove;
+};
+
+struct SgfGame {
+  SgfGame() : nRows (19), nCols (19), stones () { }
+
+  size_t nRows;
+  size_t nCols;
+  vector<SgfStone> stones;	// Setup stones, then moves, in order.
+};
+
+class SgfReader {
+public:
+  static size_t const maxSize = 52;
+
+  // Append every game in in to games. Returns false, having reported
+  // where, if in isn't SGF.
+
+  static bool read(FILE *in, char const *name, vector<SgfGame> &games) {
+    string text;
+    char buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), in)) != 0; ) {
+      text.append(buffer, n);
+    }
+
+    SgfReader reader(text, name);
+    reader.skipSpace();
+    while (reader.at < text.size()) {
+      SgfGame game;
+      if (!reader.gameTree(&game) || !reader.onBoard(game)) {
+	return false;
+      }
+      games.push_back(game);
+      reader.skipSpace();
+    }
+    return true;
+  }
+
+private:
+  SgfReader(string const &_text, char const *_name) : text (_text), name (_name), at (0) { }
+
+  // GameTree = "(" Sequence { GameTree } ")". Only the first GameTree
+  // under a Sequence is the main line; game is 0 inside the others.
+
+  bool gameTree(SgfGame *game) {
+    if (!expect('(')) {
+      return false;
+    }
+    skipSpace();
+    while (peek() == ';') {
+      at += 1;
+      if (!node(game)) {
+	return false;
+      }
+      skipSpace();
+    }
+    for (bool first = true; peek() == '('; first = false) {
+      if (!gameTree(first ? game : 0)) {
+	return false;
+      }
+      skipSpace();
+    }
+    return expect(')');
+  }
+
+  // Node = { PropIdent PropValue { PropValue } }.
+
+  bool node(SgfGame *game) {
+    for (skipSpace(); isalpha(peek()); skipSpace()) {
+      string ident;
+      for (; isalpha(peek()); at += 1) {
+	if (isupper(peek())) {
+	  ident += text[at];
+	}
+      }
+
+      skipSpace();
+      if (peek() != '[') {
+	return error("expected a property value");
+      }
+      for (; peek() == '['; skipSpace()) {
+	string value;
+	if (!propValue(value)) {
+	  return false;
+	}
+	if (game && !property(game, ident, value)) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  bool propValue(string &value) {
+    at += 1;
+    while (at < text.size() && text[at] != ']') {
+      if (text[at] == '\\') {
+	at += 1;
+      }
+      if (at < text.size()) {
+	value += text[at++];
+      }
+    }
+    return expect(']');
+  }
+
+  bool property(SgfGame *game, string const &ident, string const &value) {
+    if (ident == "SZ") {
+      char *end;
+      game->nCols = strtoul(value.c_str(), &end, 10);
+      game->nRows = *end == ':' ? strtoul(end + 1, &end, 10) : game->nCols;
+      if (game->nRows < 1 || maxSize < game->nRows || game->nCols < 1 || maxSize < game->nCols) {
+	return error("board size out of range");
+      }
+    } else if (ident == "B" || ident == "W") {
+      size_t row, col;
+      if (value.size() == 2 && point(value[1], value[0], row, col)) {
+	game->stones.push_back(SgfStone(row, col, ident == "W", true));
+      }
+    } else if (ident == "AB" || ident == "AW") {
+      size_t r0, c0, r1, c1;
+      bool ok = 2 <= value.size() && point(value[1], value[0], r0, c0);
+      if (value.size() == 5 && value[2] == ':') {
+	ok = ok && point(value[4], value[3], r1, c1);
+      } else {
+	ok = ok && value.size() == 2 && point(value[1], value[0], r1, c1);
+      }
+      if (!ok) {
+	return error("bad point in AB or AW");
+      }
+      for (size_t r = r0; r <= r1; r += 1) {
+	for (size_t c = c0; c <= c1; c += 1) {
+	  game->stones.push_back(SgfStone(r, c, ident == "AW", false));
+	}
+      }
+    }
+    return true;
+  }
+
+  // Properties come in any order within a node, so SZ can follow the
+  // stones it bounds (as in "(;AB[ss]SZ[9])"): check them against it
+  // once the whole game is read. A move off the board is a pass (tt,
+  // up to 19x19), and is dropped; a setup stone off it is an error.
+
+  bool onBoard(SgfGame &game) const {
+    vector<SgfStone> stones;
+    for (auto const &stone : game.stones) {
+      if (stone.row < game.nRows && stone.col < game.nCols) {
+	stones.push_back(stone);
+      } else if (!stone.isMove) {
+	return error("AB or AW off the board");
+      }
+    }
+    game.stones.swap(stones);
+    return true;
+  }
+
+  static bool point(char r, char c, size_t &row, size_t &col) {
+    return letter(r, row) && letter(c, col);
+  }
+  static bool letter(char l, size_t &n) {
+    if ('a' <= l && l <= 'z') {
+      n = size_t(l - 'a');
+      return true;
+    }
+    if ('A' <= l && l <= 'Z') {
+      n = size_t(l - 'A') + 26;
+      return true;
+    }
+    return false;
+  }
+
+  int peek() const {
+    return at < text.size() ? (unsigned char) text[at] : EOF;
+  }
+  void skipSpace() {
+    while (at < text.size() && isspace((unsigned char) text[at])) {
+      at += 1;
+    }
+  }
+  bool expect(char c) {
+    if (peek() != c) {
+      return error(c == ')' ? "expected ')'" : c == ']' ? "expected ']'" : "expected '('");
+    }
+    at += 1;
+    return true;
+  }
+  bool error(char const *what) const {
+    fprintf(stderr, "%s: offset %zu: %s\n", name, at, what);
+    return false;
+  }
+
+  string const &text;
+  char const *name;
+  size_t at;
+};
+
+#endif // SGFREADER_H
@@ -0,0 +1,115 @@
+#ifndef STATICLINETABLE_H
+#define STATICLINETABLE_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <array>
+using std::array;
+
+#include "boardlocation.h"
+#include "lineid.h"
+#include "line.h"
+#include "linetable.h"
+#include "lineset.h"
+
+// The same lines, in the same order, as LineTable<NRows, NCols>, but
+// generated by the compiler: the offsets and pixels are constexpr
+// arrays, so they cost nothing at startup and live in read-only
+// storage shared by every process running the binary.
+//
+// Compile-time evaluation grows with the fourth power of the board
+// size; past 13x13 or so GCC needs a larger -fconstexpr-ops-limit.
+
+template<size_t NRows, size_t NCols> struct StaticLineData {
+  typedef Line<NRows, NCols> LineRC;
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  static constexpr size_t nPoints = NRows * NCols;
+  static constexpr size_t nLines = nPoints * (nPoints - 1);
+
+  static constexpr size_t countPixels() {
+    size_t n = 0;
+    for (size_t src = 0; src < nPoints; src += 1) {
+      for (size_t dst = 0; dst < nPoints; dst += 1) {
+	if (src != dst) {
+	  n += LineRC::length(src / NCols, src % NCols, dst / NCols, dst % NCols);
+	}
+      }
+    }
+    return n;
+  }
+
+  static constexpr size_t nPixels = countPixels();
+
+  constexpr StaticLineData() :
+    offsets (),
+    pixels ()
+  {
+    size_t id = 0;
+    size_t k = 0;
+
+    for (size_t src = 0; src < nPoints; src += 1) {
+      for (size_t dst = 0; dst < nPoints; dst += 1) {
+	if (src != dst) {
+	  offsets[id] = uint32_t(k);
+	  LineRC::bresenham(src / NCols, src % NCols, dst / NCols, dst % NCols,
+			    [&](int x, int y) { pixels[k++] = Pixel((x * NCols) + y); });
+	  id += 1;
+	}
+      }
+    }
+    offsets[id] = uint32_t(k);
+  }
+
+  array<uint32_t, nLines + 1> offsets;
+  array<Pixel, nPixels> pixels;
+};
+
+template<size_t NRows, size_t NCols> class StaticLineTable : public LineTableBase<StaticLineTable<NRows, NCols>> {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef StaticLineData<NRows, NCols> StaticLineDataRC;
+  typedef typename LineTable<NRows, NCols>::LineIndex LineIndex;
+  typedef typename StaticLineDataRC::Pixel Pixel;
+
+  // The pixels of one line, src to dst inclusive, packed as in
+  // LineTable.
+
+  typedef PackedPixels<NRows, NCols> Pixels;
+
+  static size_t const nPoints = StaticLineDataRC::nPoints;
+  static size_t const nLines = StaticLineDataRC::nLines;
+  static constexpr size_t maxLinesThrough = LineTable<NRows, NCols>::maxLinesThrough;
+
+  static StaticLineTable const &instance() {
+    static StaticLineTable const table;
+    return table;
+  }
+
+  static LineIndex indexOf(LineIdRC const &lineId) {
+    return LineTable<NRows, NCols>::indexOf(lineId);
+  }
+  static LineIdRC lineIdOf(LineIndex index) {
+    return LineTable<NRows, NCols>::lineIdOf(index);
+  }
+
+  size_t size() const { return nLines; }
+  Pixels operator[](LineIndex index) const {
+    Pixels line = {
+      data.pixels.data() + data.offsets[index],
+      data.pixels.data() + data.offsets[index + 1]
+    };
+    return line;
+  }
+
+private:
+  StaticLineTable() { }
+  StaticLineTable(StaticLineTable const &);
+
+  static constexpr StaticLineDataRC data = StaticLineDataRC();
+};
+
+#endif // STATICLINETABLE_H
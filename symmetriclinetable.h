@@ -0,0 +1,149 @@
+#ifndef SYMMETRICLINETABLE_H
+#define SYMMETRICLINETABLE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include <array>
+using std::array;
+
+#include <vector>
+using std::vector;
+
+#include "boardlocation.h"
+#include "lineid.h"
+#include "line.h"
+#include "linetable.h"
+#include "lineset.h"
+#include "symmetry.h"
+
+// The lines of LineTable<NRows, NCols>, same indices, but stored only
+// for canonical sources: those at the smallest offset in their orbit
+// under the board's symmetries (see symmetry.h). A line from any other
+// src is the stored line from the canonical image of src, mapped back
+// through the inverse symmetry as it is walked. That is about an
+// eighth of the storage on a square board, and a quarter otherwise.
+//
+// On the boards checked so far (5x7, 9x9 and 19x19) every line read
+// back this way matches LineTable's pixel for pixel. Should Bresenham's
+// tie-breaking ever not commute with a symmetry, the line read back is
+// still an 8-connected digital line from src to dst, and it is then the
+// exact mirror of the canonical one.
+
+template<size_t NRows, size_t NCols> class SymmetricLineTable : public LineTableBase<SymmetricLineTable<NRows, NCols>> {
+public:
+  typedef BoardLocation<NRows, NCols> LocationRC;
+  typedef LineId<NRows, NCols> LineIdRC;
+  typedef Line<NRows, NCols> LineRC;
+  typedef Symmetries<NRows, NCols> SymmetriesRC;
+  typedef typename LineTable<NRows, NCols>::LineIndex LineIndex;
+  typedef typename PackedPixel<NRows, NCols>::type Pixel;
+
+  static size_t const nPoints = NRows * NCols;
+  static size_t const nLines = nPoints * (nPoints - 1);
+  static constexpr size_t maxLinesThrough = LineTable<NRows, NCols>::maxLinesThrough;
+
+  // Walks a stored line's pixels, packed as in LineTable, mapping each
+  // through a symmetry.
+
+  class PixelIterator {
+  public:
+    PixelIterator(Pixel const *_p, Pixel const *_map) : p (_p), map (_map) { }
+    LocationRC operator*() const { return LocationRC(size_t(map[*p])); }
+    PixelIterator &operator++() {
+      ++p;
+      return *this;
+    }
+    bool operator==(PixelIterator const &that) const { return p == that.p; }
+    bool operator!=(PixelIterator const &that) const { return p != that.p; }
+
+  private:
+    Pixel const *p;
+    Pixel const *map;
+  };
+
+  // The pixels of one line, src to dst inclusive.
+
+  struct Pixels {
+    PixelIterator begin() const { return PixelIterator(first, map); }
+    PixelIterator end() const { return PixelIterator(last, map); }
+    size_t size() const { return size_t(last - first); }
+
+    Pixel const *first;
+    Pixel const *last;
+    Pixel const *map;
+  };
+
+  static SymmetricLineTable const &instance() {
+    static SymmetricLineTable const table;
+    return table;
+  }
+
+  static LineIndex indexOf(LineIdRC const &lineId) {
+    return LineTable<NRows, NCols>::indexOf(lineId);
+  }
+  static LineIdRC lineIdOf(LineIndex index) {
+    return LineTable<NRows, NCols>::lineIdOf(index);
+  }
+
+  size_t size() const { return nLines; }
+  size_t nCanonicalSources() const { return (offsets.size() - 1) / (nPoints - 1); }
+
+  Pixels operator[](LineIndex index) const {
+    LineIdRC lineId = lineIdOf(index);
+    size_t s = canonicalizing[lineId.src];
+    size_t src = maps[s][lineId.src];
+    size_t dst = maps[s][lineId.dst];
+    size_t stored = (canonicalSources[src] * (nPoints - 1)) + (dst < src ? dst : dst - 1);
+
+    Pixels line = {
+      &pixels[0] + offsets[stored],
+      &pixels[0] + offsets[stored + 1],
+      &maps[SymmetriesRC::inverse(Symmetry(s))][0]
+    };
+    return line;
+  }
+
+private:
+  SymmetricLineTable() {
+    for (size_t s = 0; s < EoSymmetry; s += 1) {
+      for (size_t l = 0; l < nPoints; l += 1) {
+	maps[s][l] = Pixel(SymmetriesRC::apply(Symmetry(s), LocationRC(l)));
+      }
+    }
+
+    // Number the canonical sources, and rasterize every line out of
+    // each of them.
+
+    size_t nCanonical = 0;
+    for (size_t src = 0; src < nPoints; src += 1) {
+      Symmetry s = SymmetriesRC::canonicalizing(LocationRC(src));
+
+      canonicalizing[src] = uint8_t(s);
+      canonicalSources[src] = maps[s][src] == src ? uint32_t(nCanonical++) : uint32_t(nPoints);
+
+      if (maps[s][src] == src) {
+	for (size_t dst = 0; dst < nPoints; dst += 1) {
+	  if (dst != src) {
+	    offsets.push_back(uint32_t(pixels.size()));
+	    LineRC::bresenham(src / NCols, src % NCols, dst / NCols, dst % NCols,
+			      [&](int x, int y) { pixels.push_back(Pixel((x * NCols) + y)); });
+	  }
+	}
+      }
+    }
+    offsets.push_back(uint32_t(pixels.size()));
+    assert(offsets.size() == (nCanonical * (nPoints - 1)) + 1);
+  }
+  SymmetricLineTable(SymmetricLineTable const &);
+
+  array<array<Pixel, nPoints>, EoSymmetry> maps;
+  array<uint8_t, nPoints> canonicalizing;
+  array<uint32_t, nPoints> canonicalSources;
+
+  vector<uint32_t> offsets;
+  vector<Pixel> pixels;
+};
+
+#endif // SYMMETRICLINETABLE_H
@@ -0,0 +1,77 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+
+#include <array>
+using std::array;
+
+#include "boardlocation.h"
+
+// The eight rotations and reflections of a board. A square board has
+// all eight; any other board keeps only the four that preserve its
+// shape (Identity, Rotate180, FlipCols and FlipRows).
+
+enum Symmetry {
+  Identity,
+  Rotate90,
+  Rotate180,
+  Rotate270,
+  FlipCols,			// (r, c) -> (r, NCols - 1 - c)
+  FlipRows,			// (r, c) -> (NRows - 1 - r, c)
+  Transpose,			// (r, c) -> (c, r)
+  AntiTranspose,		// (r, c) -> (NCols - 1 - c, NRows - 1 - r)
+
+  EoSymmetry
+};
+
+template<size_t NRows, size_t NCols> struct Symmetries {
+  typedef BoardLocation<NRows, NCols> LocationRC;
+
+  static bool isValid(Symmetry s) {
+    return NRows == NCols || s == Identity || s == Rotate180 || s == FlipCols || s == FlipRows;
+  }
+
+  static Symmetry inverse(Symmetry s) {
+    switch (s) {
+    case Rotate90: return Rotate270;
+    case Rotate270: return Rotate90;
+    default: return s;
+    }
+  }
+
+  static LocationRC apply(Symmetry s, LocationRC l) {
+    size_t r = l.row();
+    size_t c = l.col();
+    size_t const R = NRows - 1;
+    size_t const C = NCols - 1;
+
+    switch (s) {
+    case Identity: return LocationRC(r, c);
+    case Rotate90: return LocationRC(c, R - r);
+    case Rotate180: return LocationRC(R - r, C - c);
+    case Rotate270: return LocationRC(C - c, r);
+    case FlipCols: return LocationRC(r, C - c);
+    case FlipRows: return LocationRC(R - r, c);
+    case Transpose: return LocationRC(c, r);
+    case AntiTranspose: return LocationRC(C - c, R - r);
+    case EoSymmetry: break;
+    }
+    return l;
+  }
+
+  // The valid symmetry taking l to the smallest offset in its orbit,
+  // its canonical representative.
+
+  static Symmetry canonicalizing(LocationRC l) {
+    Symmetry best = Identity;
+    for (size_t s = 0; s < EoSymmetry; s += 1) {
+      if (isValid(Symmetry(s)) && size_t(apply(Symmetry(s), l)) < size_t(apply(best, l))) {
+	best = Symmetry(s);
+      }
+    }
+    return best;
+  }
+};
+
+#endif // SYMMETRY_H
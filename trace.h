@@ -0,0 +1,144 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+// Trace policies for Board::put(). The Board calls, for each put():
+//
+//	put(l, state, name)	on entry, with the State and its name
+//	line(id, lineId)	for each live line through l, once placed
+//	pixel(q)		for each pixel of a line the stone blocks
+//	blocked()		after the last pixel of that line
+//	done(placed)		on return
+//
+// NoTrace does nothing, inline, so a Board built on it compiles to the
+// same code as one without tracing. TextTrace writes the same text put()
+// always has, but gathers each put() into one buffer and writes it with
+// a single fwrite() rather than an fflush() per pixel. BinaryTrace keeps
+// every call as a fixed-size TraceRecord, for reading back later.
+
+struct NoTrace {
+  template<typename LocationT> void put(LocationT, unsigned, char const *) { }
+  template<typename LineIdT> void line(size_t, LineIdT const &) { }
+  template<typename LocationT> void pixel(LocationT) { }
+  void blocked() { }
+  void done(bool) { }
+};
+
+class TextTrace {
+public:
+  explicit TextTrace(FILE *_out = stdout) : out (_out), text (), comma1 (""), comma2 ("") { }
+
+  template<typename LocationT> void put(LocationT l, unsigned, char const *name) {
+    text.clear();
+    text += "Board::put(l=";
+    append(l);
+    text += ", s=";
+    text += name;
+    text += ") ";
+    comma1 = "{";
+  }
+  template<typename LineIdT> void line(size_t, LineIdT const &lineId) {
+    text += comma1;
+    text += " ";
+    append(lineId.src);
+    text += "..";
+    append(lineId.dst);
+    comma1 = ",";
+    comma2 = " {";
+  }
+  template<typename LocationT> void pixel(LocationT q) {
+    text += comma2;
+    text += " ";
+    append(q);
+    comma2 = ",";
+  }
+  void blocked() {
+    text += " }";
+  }
+  void done(bool placed) {
+    text += placed ? " }\n" : "\n";
+    fwrite(text.data(), 1, text.size(), out);
+  }
+
+private:
+  // BoardLocation::fprint() in memory: row and column as letters.
+
+  template<typename LocationT> void append(LocationT l) {
+    text += char('a' + l.row());
+    text += char('a' + l.col());
+  }
+
+  FILE *out;
+  string text;
+  char const *comma1;
+  char const *comma2;
+};
+
+enum TraceKind {
+  TracePut,			// a = location, b = state
+  TraceLine,			// a = line index
+  TracePixel,			// a = location
+  TraceBlocked,
+  TraceDone,			// a = placed
+
+  EoTraceKind
+};
+
+struct TraceRecord {
+  uint32_t kind;
+  uint32_t a;
+  uint32_t b;
+};
+
+class BinaryTrace {
+public:
+  BinaryTrace() : records () { }
+
+  template<typename LocationT> void put(LocationT l, unsigned state, char const *) {
+    record(TracePut, uint32_t(size_t(l)), state);
+  }
+  template<typename LineIdT> void line(size_t id, LineIdT const &) {
+    record(TraceLine, uint32_t(id), 0);
+  }
+  template<typename LocationT> void pixel(LocationT q) {
+    record(TracePixel, uint32_t(size_t(q)), 0);
+  }
+  void blocked() {
+    record(TraceBlocked, 0, 0);
+  }
+  void done(bool placed) {
+    record(TraceDone, placed ? 1 : 0, 0);
+  }
+
+  vector<TraceRecord> const &trace() const {
+    return records;
+  }
+  void clear() {
+    records.clear();
+  }
+
+  // Write every record so far to out, raw, as the program that reads
+  // them back will have the same TraceRecord.
+
+  bool fwrite(FILE *out) const {
+    return ::fwrite(records.data(), sizeof(TraceRecord), records.size(), out) == records.size();
+  }
+
+private:
+  void record(TraceKind kind, uint32_t a, uint32_t b) {
+    TraceRecord r = { uint32_t(kind), a, b };
+    records.push_back(r);
+  }
+
+  vector<TraceRecord> records;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,94 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+#include <array>
+using std::array;
+
+// Zobrist keys for an NRows x NCols board: a random Key for a black and
+// a white stone at each point, and one for White to move. A position's
+// hash is the xor of the keys of its stones, so a board keeps it up to
+// date with one xor per stone placed or taken, and the empty board
+// hashes to 0.
+//
+// The keys come from a fixed seed, mixed with the board's size, so
+// they are the same in every run and every program: equal positions
+// hash equal wherever they came from, and different sizes don't share
+// keys.
+//
+// Key is uint64_t, or ZobristKey128 where 64 bits would collide too
+// often.
+
+struct ZobristKey128 {
+  ZobristKey128() : lo (0), hi (0) { }
+  ZobristKey128(uint64_t _lo, uint64_t _hi) : lo (_lo), hi (_hi) { }
+
+  ZobristKey128 &operator^=(ZobristKey128 const &that) {
+    lo ^= that.lo;
+    hi ^= that.hi;
+    return *this;
+  }
+  ZobristKey128 operator^(ZobristKey128 const &that) const { return ZobristKey128(*this) ^= that; }
+
+  bool operator==(ZobristKey128 const &that) const { return lo == that.lo && hi == that.hi; }
+  bool operator!=(ZobristKey128 const &that) const { return !(*this == that); }
+  bool operator<(ZobristKey128 const &that) const { return hi < that.hi || (hi == that.hi && lo < that.lo); }
+
+  uint64_t lo;
+  uint64_t hi;
+};
+
+// SplitMix64: small, fast, and good enough to fill a key table.
+
+inline uint64_t splitMix64(uint64_t &state)
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+inline void nextZobristKey(uint64_t &state, uint64_t &key)
+{
+  key = splitMix64(state);
+}
+inline void nextZobristKey(uint64_t &state, ZobristKey128 &key)
+{
+  key.lo = splitMix64(state);
+  key.hi = splitMix64(state);
+}
+
+template<size_t NRows, size_t NCols, typename Key = uint64_t> class Zobrist {
+public:
+  static size_t const nPoints = NRows * NCols;
+
+  static Zobrist const &instance() {
+    static Zobrist const keys;
+    return keys;
+  }
+
+  // The key of a stone at point l: black if !isWhite, else white.
+
+  Key const &stone(size_t l, bool isWhite) const {
+    return stones[(2 * l) + (isWhite ? 1 : 0)];
+  }
+  Key const &whiteToMove() const {
+    return toMove;
+  }
+
+private:
+  Zobrist() {
+    uint64_t state = 0x5a0b12157ull ^ (uint64_t(NRows) << 40) ^ (uint64_t(NCols) << 20);
+    for (size_t k = 0; k < stones.size(); k += 1) {
+      nextZobristKey(state, stones[k]);
+    }
+    nextZobristKey(state, toMove);
+  }
+  Zobrist(Zobrist const &);
+
+  array<Key, 2 * nPoints> stones;
+  Key toMove;
+};
+
+#endif // ZOBRIST_H